@@ -30,6 +30,21 @@ int main(void){
     UCCONFIG_setOnFirstWrite(&onFirstWrite);
     UCCONFIG_setOnExit(&onExit);
 
+    //With a DMA or FIFO serial driver, each response frame can be sent with one call instead of a call per byte:
+    //UCCONFIG_setSerialBlock(&serialWriteBlock);
+
+    //Instead of erasing in onFirstWrite(), the module can erase only the pages a session changes and keep
+    //the rest of each one, using a staging buffer of whole pages (1K on the STM32F103CB):
+    //static uint8_t stage[1024];
+    //UCCONFIG_setStaging(stage,sizeof(stage),1024);
+    //UCCONFIG_setGeometry(1024,&flashErasePage,0xFF);
+
+    //To avoid erasing a page for every change, flashLog.h keeps the variables as records appended to two pages.
+    //It replaces the setup above and the erase in onFirstWrite():
+    //FLASHLOG_setup(&flashReadBlock,&flashProgram,&flashErase);
+    //FLASHLOG_init(0x0801F800,0x0801FC00,1024,2,image,sizeof(image));
+    //UCCONFIG_setupBlock(&FLASHLOG_read,&FLASHLOG_write,&serialWrite);
+
     //Fetch high and low times, just call the onExit function
     onExit();
 
@@ -69,6 +84,13 @@ void onExit(void){
     //Use this so variables are updated at 'real time' as soon as the write operation completes
     UCCONFIG_get(&highDelay,HIGH_DELAY);
     UCCONFIG_get(&lowDelay,LOW_DELAY);
+
+    //With many variables, ucconfig_load_all() from the generated header fills a struct of all of them in one read
+    //ucconfig_vars_t vars;
+    //ucconfig_load_all(&vars);
+
+    //The STM32 internal flash is memory mapped, building with eg. -DUCCONFIG_MEMORY_MAPPED -DUCCONFIG_MEMORY_BASE=0x0801FC00
+    //(the last 1K page) makes each UCCONFIG_get() a single load instead of calls to flashRead()
 }
 
 uint8_t flashRead(uint16_t address){
@@ -15,6 +15,12 @@
 */
 
 #include "fifo8.h"
+#include <string.h>
+
+//Copy length bytes into the buffer starting at position, wrapping around the end
+static void fifo8_copyIn(uint8_t *buffer, uint16_t mask, uint16_t position, const uint8_t *data, uint16_t length);
+//Copy length bytes out of the buffer starting at position, wrapping around the end
+static void fifo8_copyOut(const uint8_t *buffer, uint16_t mask, uint16_t position, uint8_t *data, uint16_t length);
 
 
 fifo8_error_t FIFO8_put(FIFO8 *target, uint8_t byte){
@@ -126,3 +132,161 @@ uint8_t FIFO8_pop(FIFO8 *target){
 
 }
 
+uint16_t FIFO8_putn(FIFO8 *target, const uint8_t *data, uint16_t length){
+
+    //One position is always left empty to tell a full fifo from an empty one
+    uint16_t space = (target->tail - target->head - 1) & target->mask;
+
+    if(length > space){
+        length = space;
+    }
+
+    fifo8_copyIn(target->buffer,target->mask,target->head,data,length);
+	target->head = (target->head + length) & target->mask;
+
+    //Start dumping characters if need
+	if((length > 0) && (target->idle == 1) && (target->mode == FIFO8_AUTO)){
+
+		FIFO8_get(target);
+	}
+
+    return length;
+}
+
+uint16_t FIFO8_popn(FIFO8 *target, uint8_t *data, uint16_t length){
+
+    uint16_t size = FIFO8_size(target);
+
+    if(length > size){
+        length = size;
+    }
+
+    fifo8_copyOut(target->buffer,target->mask,target->tail,data,length);
+	target->tail = (target->tail + length) & target->mask;
+
+    //Idle once emptied, the same as FIFO8_pop() and FIFO8_get() report an empty fifo
+    //so FIFO8_put() and FIFO8_putn() restart the output in AUTO mode
+	target->idle = (length == size);
+
+    return length;
+}
+
+static void fifo8_copyIn(uint8_t *buffer, uint16_t mask, uint16_t position, const uint8_t *data, uint16_t length){
+
+    //Bytes up to the end of the buffer, then the rest from the start
+    uint16_t first = (mask + 1) - position;
+
+    if(first > length){
+        first = length;
+    }
+
+    memcpy(&buffer[position],data,first);
+    memcpy(buffer,&data[first],length - first);
+}
+
+static void fifo8_copyOut(const uint8_t *buffer, uint16_t mask, uint16_t position, uint8_t *data, uint16_t length){
+
+    //Bytes up to the end of the buffer, then the rest from the start
+    uint16_t first = (mask + 1) - position;
+
+    if(first > length){
+        first = length;
+    }
+
+    memcpy(data,&buffer[position],first);
+    memcpy(&data[first],buffer,length - first);
+}
+
+fifo8_error_t FIFO8_spscInit(FIFO8_SPSC *target, uint8_t *buffer, uint16_t size){
+
+    //First check if the size is a power of 2
+    if(!(size && !(size & (size - 1)))){
+
+        return E_FIFO8_NONBINARY;
+    }
+
+	target->buffer = buffer;
+	target->mask = size - 1;
+	atomic_init(&target->head,0);
+	atomic_init(&target->tail,0);
+
+    return E_FIFO8_NOERROR;
+}
+
+fifo8_error_t FIFO8_spscPut(FIFO8_SPSC *target, uint8_t byte){
+
+    //Only the producer writes the head, the tail is acquired so the consumer is done with the slot
+    uint16_t head = atomic_load_explicit(&target->head,memory_order_relaxed);
+    uint16_t tail = atomic_load_explicit(&target->tail,memory_order_acquire);
+
+    //The fifo is full when the head is one position behind the tale
+	if(head == ((tail-1) & target->mask)){
+
+		return E_FIFO8_FULL;
+	}
+
+    //Write the byte before the consumer can see the new head
+	target->buffer[head] = byte;
+	atomic_store_explicit(&target->head,(head + 1) & target->mask,memory_order_release);
+
+    return E_FIFO8_NOERROR;
+}
+
+fifo8_error_t FIFO8_spscPop(FIFO8_SPSC *target, uint8_t *byte){
+
+    //Only the consumer writes the tail, the head is acquired so the byte written is visible
+    uint16_t tail = atomic_load_explicit(&target->tail,memory_order_relaxed);
+    uint16_t head = atomic_load_explicit(&target->head,memory_order_acquire);
+
+    //The fifo is empty when the head and tail are at the same position.
+	if(head == tail){
+
+		return E_FIFO8_EMPTY;
+	}
+
+    //Read the byte before the producer can reuse the slot
+	*byte = target->buffer[tail];
+	atomic_store_explicit(&target->tail,(tail + 1) & target->mask,memory_order_release);
+
+    return E_FIFO8_NOERROR;
+}
+
+uint16_t FIFO8_spscPutn(FIFO8_SPSC *target, const uint8_t *data, uint16_t length){
+
+    uint16_t head = atomic_load_explicit(&target->head,memory_order_relaxed);
+    uint16_t tail = atomic_load_explicit(&target->tail,memory_order_acquire);
+    uint16_t space = (tail - head - 1) & target->mask;
+
+    if(length > space){
+        length = space;
+    }
+
+    //Copy everything before the consumer can see any of it
+    fifo8_copyIn(target->buffer,target->mask,head,data,length);
+	atomic_store_explicit(&target->head,(head + length) & target->mask,memory_order_release);
+
+    return length;
+}
+
+uint16_t FIFO8_spscPopn(FIFO8_SPSC *target, uint8_t *data, uint16_t length){
+
+    uint16_t tail = atomic_load_explicit(&target->tail,memory_order_relaxed);
+    uint16_t head = atomic_load_explicit(&target->head,memory_order_acquire);
+    uint16_t size = (head - tail) & target->mask;
+
+    if(length > size){
+        length = size;
+    }
+
+    //Copy everything before the producer can reuse any of it
+    fifo8_copyOut(target->buffer,target->mask,tail,data,length);
+	atomic_store_explicit(&target->tail,(tail + length) & target->mask,memory_order_release);
+
+    return length;
+}
+
+uint16_t FIFO8_spscSize(FIFO8_SPSC *target){
+
+	return (atomic_load_explicit(&target->head,memory_order_acquire) - 
+            atomic_load_explicit(&target->tail,memory_order_acquire)) & target->mask;
+}
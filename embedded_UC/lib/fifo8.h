@@ -37,6 +37,7 @@
 #define FIFO8_H
 
 #include <stdio.h>
+#include <stdatomic.h>
 
 /*! 
     @brief Operating modes for the buffer.
@@ -83,6 +84,26 @@ typedef struct{
 	void (*out)(uint8_t byte);      //!<Pointer to the output function used by read function FIFO_get()
 }FIFO8;
 
+/*! 
+    @brief Data structure for a single producer, single consumer FIFO8.
+    @details 
+
+    One context, eg. a receive interrupt, may only call FIFO8_spscPut() and one other context, eg. the
+    main loop, may only call FIFO8_spscPop(). Each side only writes its own position, and publishes it with
+    release ordering after the buffer access, so neither needs to disable interrupts or take a lock.
+
+    There is no output function or mode, bytes are taken with FIFO8_spscPop().
+
+    A new instance of this structure must be initialized by FIFO8_spscInit().
+*/
+typedef struct{
+
+	uint8_t *buffer;                //!<Pointer to the FIFO8 memory buffer.
+	_Atomic uint16_t head;          //!<The current write position, only written by the producer
+	_Atomic uint16_t tail;          //!<The current read position, only written by the consumer
+	uint16_t mask;                  //!<Bit mask used for FIFO8 buffer memory wrapping
+}FIFO8_SPSC;
+
 /*! 
     @brief Initializes the FIFO8 buffer.
     @details This must be called before any other function of the FIFO8 buffer will work.
@@ -132,6 +153,77 @@ fifo8_error_t FIFO8_flush(FIFO8 *target);
 
 uint8_t FIFO8_pop(FIFO8 *target);
 
+/*! 
+    @brief Adds up to length characters to the buffer.
+    @details The bytes are copied with at most two memcpy calls, wrapping around the end of the buffer.
+    If the FIFO8 mode is #FIFO8_AUTO and the output is idle, this will start the output stream as well.
+    @param target Pointer to the FIFO8 object to add bytes to.
+    @param data Pointer to the first byte to add.
+    @param length The number of bytes to add.
+    @return The number of bytes added, less than length if the buffer filled.
+*/
+uint16_t FIFO8_putn(FIFO8 *target, const uint8_t *data, uint16_t length);
+/*! 
+    @brief Takes up to length characters from the buffer without passing them to the output function.
+    @details The bytes are copied with at most two memcpy calls, wrapping around the end of the buffer.
+    The FIFO8 is idle once emptied, so in #FIFO8_AUTO mode the next put starts the output again.
+    @param target Pointer to the FIFO8 object to take bytes from.
+    @param data Pointer to where the bytes taken are stored.
+    @param length The maximum number of bytes to take.
+    @return The number of bytes taken, less than length if the buffer emptied.
+*/
+uint16_t FIFO8_popn(FIFO8 *target, uint8_t *data, uint16_t length);
+
+/*! 
+    @brief Initializes a single producer, single consumer FIFO8 buffer.
+    @details This must be called before either side uses the buffer.
+    @param target Pointer to the FIFO8_SPSC object to initialize.
+    @param buffer Pointer to the first byte of memory to be used for the buffer.
+    @param size The size of the buffer (Must be a power or 2).
+    @return E_FIFO8_NOERROR if no error or E_FIFO8_NONBINARY if the memory buffer isn't a power of 2.
+*/
+fifo8_error_t FIFO8_spscInit(FIFO8_SPSC *target, uint8_t *buffer, uint16_t size);
+/*! 
+    @brief Adds a character to the buffer, only call from the producer.
+    @param target Pointer to the FIFO8_SPSC object to add a byte to.
+    @param byte The byte to add to the buffer.
+    @return E_FIFO8_FULL if the buffer is full, E_FIFO8_NOERROR if it is not.
+*/
+fifo8_error_t FIFO8_spscPut(FIFO8_SPSC *target, uint8_t byte);
+/*! 
+    @brief Takes a character from the buffer, only call from the consumer.
+    @param target Pointer to the FIFO8_SPSC object to take a byte from.
+    @param byte Pointer to where the byte taken is stored.
+    @return E_FIFO8_EMPTY if the buffer is empty, E_FIFO8_NOERROR if it is not.
+*/
+fifo8_error_t FIFO8_spscPop(FIFO8_SPSC *target, uint8_t *byte);
+/*! 
+    @brief Adds up to length characters to the buffer, only call from the producer.
+    @details The bytes are copied with at most two memcpy calls and published together.
+    @param target Pointer to the FIFO8_SPSC object to add bytes to.
+    @param data Pointer to the first byte to add.
+    @param length The number of bytes to add.
+    @return The number of bytes added, less than length if the buffer filled.
+*/
+uint16_t FIFO8_spscPutn(FIFO8_SPSC *target, const uint8_t *data, uint16_t length);
+/*! 
+    @brief Takes up to length characters from the buffer, only call from the consumer.
+    @details The bytes are copied with at most two memcpy calls and released together.
+    @param target Pointer to the FIFO8_SPSC object to take bytes from.
+    @param data Pointer to where the bytes taken are stored.
+    @param length The maximum number of bytes to take.
+    @return The number of bytes taken, less than length if the buffer emptied.
+*/
+uint16_t FIFO8_spscPopn(FIFO8_SPSC *target, uint8_t *data, uint16_t length);
+/*! 
+    @brief Return the number of bytes in the buffer.
+    @details May be called from either side. The other side can change it straight after, the
+    consumer can only see it grow and the producer can only see it shrink.
+    @param target Pointer to the FIFO8_SPSC object to get the size of.
+    @return The number of bytes in the buffer.
+*/
+uint16_t FIFO8_spscSize(FIFO8_SPSC *target);
+
 /**@}*/
 /**@}*/
 #endif
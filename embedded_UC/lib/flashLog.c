@@ -0,0 +1,363 @@
+/*!
+    @file flashLog.c
+    @brief Source file for flashLog.h
+    @version 0.1
+    @copyright GNU GPLv3
+    @warning None
+    @bug
+
+    @details
+*/
+
+#include "flashLog.h"
+#include <string.h>
+
+//Marks the start of a page which holds records, followed by the 16 bit sequence number
+#define FLASHLOG_MAGIC_1 0x55
+#define FLASHLOG_MAGIC_2 0xC0
+
+//Bytes before the data of a record, address (2), length and check byte
+#define FLASHLOG_RECORD_HEADER 4
+
+//Value of the program unit after a record which is only written once the record is complete
+#define FLASHLOG_COMMITTED 0x00
+
+static void (*logRead)(uint32_t,uint8_t*,uint16_t);
+static void (*logProgram)(uint32_t,const uint8_t*,uint16_t);
+static void (*logErase)(uint32_t);
+
+static uint32_t pages[2];
+static uint16_t pageSize;
+static uint8_t programSize;
+static uint8_t *image;
+static uint16_t imageSize;
+
+//Index of the page records are appended to, -1 before the first write to a blank store
+static int8_t active = -1;
+static uint16_t sequence;
+//Offset in the active page of the next record
+static uint16_t writeOffset;
+
+//Bytes used by a record of the given data length including its commit unit, a whole number of program units
+static uint16_t flashlog_recordSize(uint8_t length);
+
+//Bytes used by the page header, a whole number of program units
+static uint16_t flashlog_headerSize(void);
+
+//Check byte of a record, never matches a record which is all erased or all zero
+static uint8_t flashlog_check(uint16_t address,const uint8_t *data,uint8_t length);
+
+//Program a record at the offset of a page, returns the bytes used
+static uint16_t flashlog_program(uint32_t page,uint16_t offset,uint16_t address,const uint8_t *data,uint8_t length);
+
+//Returns 1 if every byte of a commit unit has been programmed
+static uint8_t flashlog_committed(const uint8_t *commit);
+
+//Copy the records of a page into the image and find the end of them
+static void flashlog_replay(uint8_t page);
+
+//Returns 1 and the sequence number if the page has been written by a compaction
+static uint8_t flashlog_pageSequence(uint8_t page,uint16_t *pageSequence);
+
+void FLASHLOG_setup(
+        void (*read)(uint32_t,uint8_t*,uint16_t),
+        void (*program)(uint32_t,const uint8_t*,uint16_t),
+        void (*erase)(uint32_t)){
+
+    logRead = read;
+    logProgram = program;
+    logErase = erase;
+}
+
+flashlog_error_t FLASHLOG_init(uint32_t pageA,uint32_t pageB,uint16_t size,uint8_t unit,
+        uint8_t *buffer,uint16_t bufferSize){
+
+    uint16_t sequenceA;
+    uint16_t sequenceB;
+    uint8_t validA;
+    uint8_t validB;
+    uint32_t compacted;
+
+    image = NULL;
+    active = -1;
+
+    if((logRead == NULL) || (logProgram == NULL) || (logErase == NULL) || (buffer == NULL)){
+        return E_FLASHLOG_NOFUNCTION;
+    }
+
+    if((unit != 1) && (unit != 2) && (unit != 4) && (unit != 8)){
+        return E_FLASHLOG_PROGRAMSIZE;
+    }
+
+    pages[0] = pageA;
+    pages[1] = pageB;
+    pageSize = size;
+    programSize = unit;
+
+    //A compaction of a full image has to leave room for at least one more record
+    compacted = flashlog_headerSize();
+    compacted += (uint32_t)((bufferSize + FLASHLOG_RECORD_DATA - 1) / FLASHLOG_RECORD_DATA) * flashlog_recordSize(FLASHLOG_RECORD_DATA);
+    compacted += flashlog_recordSize(FLASHLOG_RECORD_DATA);
+
+    if(compacted > pageSize){
+        return E_FLASHLOG_SIZE;
+    }
+
+    image = buffer;
+    imageSize = bufferSize;
+    memset(image,FLASHLOG_ERASED,imageSize);
+
+    validA = flashlog_pageSequence(0,&sequenceA);
+    validB = flashlog_pageSequence(1,&sequenceB);
+
+    //The newest page is the active one, sequence numbers wrap
+    if(validA && (!validB || ((int16_t)(sequenceA - sequenceB) >= 0))){
+
+        active = 0;
+        sequence = sequenceA;
+    }
+    else if(validB){
+
+        active = 1;
+        sequence = sequenceB;
+    }
+    else{
+
+        //Blank store, the first write compacts into page A
+        sequence = 0;
+        return E_FLASHLOG_NOERROR;
+    }
+
+    flashlog_replay((uint8_t)active);
+
+    return E_FLASHLOG_NOERROR;
+}
+
+void FLASHLOG_read(uint16_t address,uint8_t *data,uint16_t length){
+
+    uint16_t i;
+
+    for(i = 0; i < length; i++){
+
+        if((image != NULL) && ((uint32_t)address + i < imageSize)){
+            data[i] = image[address + i];
+        }
+        else{
+            data[i] = FLASHLOG_ERASED;
+        }
+    }
+}
+
+void FLASHLOG_write(uint16_t address,const uint8_t *data,uint16_t length){
+
+    uint16_t first;
+    uint16_t last;
+    uint16_t offset;
+    uint16_t size;
+    uint8_t chunk;
+
+    if((image == NULL) || (address >= imageSize) || (length == 0)){
+        return;
+    }
+
+    if(length > imageSize - address){
+        length = imageSize - address;
+    }
+
+    //Only the span which changed is appended
+    for(first = 0; (first < length) && (image[address + first] == data[first]); first++);
+
+    if(first == length){
+        return;
+    }
+
+    for(last = length - 1; image[address + last] == data[last]; last--);
+
+    memcpy(&image[address + first],&data[first],last - first + 1);
+
+    for(offset = first; offset <= last; offset += chunk){
+
+        chunk = (last - offset + 1 > FLASHLOG_RECORD_DATA) ? FLASHLOG_RECORD_DATA : (uint8_t)(last - offset + 1);
+        size = flashlog_recordSize(chunk);
+
+        //The image already holds the whole write, so compacting stores the rest of it too
+        if((active < 0) || ((uint32_t)writeOffset + size > pageSize)){
+
+            FLASHLOG_compact();
+            return;
+        }
+
+        writeOffset += flashlog_program(pages[active],writeOffset,address + offset,&image[address + offset],chunk);
+    }
+}
+
+void FLASHLOG_compact(void){
+
+    uint8_t target;
+    uint8_t chunk;
+    uint8_t i;
+    uint16_t address;
+    uint16_t offset;
+    uint8_t header[8];
+
+    if(image == NULL){
+        return;
+    }
+
+    target = (active == 0) ? 1 : 0;
+    logErase(pages[target]);
+    offset = flashlog_headerSize();
+
+    for(address = 0; address < imageSize; address += chunk){
+
+        chunk = (imageSize - address > FLASHLOG_RECORD_DATA) ? FLASHLOG_RECORD_DATA : (uint8_t)(imageSize - address);
+
+        //Erased bytes are what the image starts as, they don't need a record
+        for(i = 0; (i < chunk) && (image[address + i] == FLASHLOG_ERASED); i++);
+
+        if(i < chunk){
+            offset += flashlog_program(pages[target],offset,address,&image[address],chunk);
+        }
+    }
+
+    //The header is written last, a reset before it leaves the old page active
+    sequence++;
+    memset(header,FLASHLOG_ERASED,sizeof(header));
+    header[0] = FLASHLOG_MAGIC_1;
+    header[1] = FLASHLOG_MAGIC_2;
+    header[2] = (uint8_t)(sequence >> 8);
+    header[3] = (uint8_t)sequence;
+    logProgram(pages[target],header,flashlog_headerSize());
+
+    active = (int8_t)target;
+    writeOffset = offset;
+}
+
+uint16_t FLASHLOG_free(void){
+
+    if(active < 0){
+        return 0;
+    }
+
+    return pageSize - writeOffset;
+}
+
+static uint16_t flashlog_recordSize(uint8_t length){
+
+    return (uint16_t)(((FLASHLOG_RECORD_HEADER + length + programSize - 1) & ~(programSize - 1)) + programSize);
+}
+
+static uint16_t flashlog_headerSize(void){
+
+    return (programSize > 4) ? programSize : 4;
+}
+
+static uint8_t flashlog_check(uint16_t address,const uint8_t *data,uint8_t length){
+
+    uint8_t sum;
+    uint8_t i;
+
+    sum = (uint8_t)(address >> 8) + (uint8_t)address + length;
+
+    for(i = 0; i < length; i++){
+        sum += data[i];
+    }
+
+    return (uint8_t)~sum;
+}
+
+static uint16_t flashlog_program(uint32_t page,uint16_t offset,uint16_t address,const uint8_t *data,uint8_t length){
+
+    uint8_t record[FLASHLOG_RECORD_HEADER + FLASHLOG_RECORD_DATA + 8];
+    uint16_t size = flashlog_recordSize(length) - programSize;
+
+    memset(record,FLASHLOG_ERASED,size);
+    record[0] = (uint8_t)(address >> 8);
+    record[1] = (uint8_t)address;
+    record[2] = length;
+    record[3] = flashlog_check(address,data,length);
+    memcpy(&record[FLASHLOG_RECORD_HEADER],data,length);
+
+    logProgram(page + offset,record,size);
+
+    //A reset part way through the record leaves this unit erased and the record is ignored
+    memset(record,FLASHLOG_COMMITTED,programSize);
+    logProgram(page + offset + size,record,programSize);
+
+    return size + programSize;
+}
+
+static void flashlog_replay(uint8_t page){
+
+    uint8_t header[FLASHLOG_RECORD_HEADER];
+    uint8_t data[FLASHLOG_RECORD_DATA];
+    uint8_t commit[8];
+    uint16_t offset;
+    uint16_t address;
+    uint16_t size;
+    uint8_t length;
+
+    offset = flashlog_headerSize();
+
+    while((uint32_t)offset + FLASHLOG_RECORD_HEADER <= pageSize){
+
+        logRead(pages[page] + offset,header,FLASHLOG_RECORD_HEADER);
+
+        //Erased header, the end of the records
+        if((header[0] & header[1] & header[2] & header[3]) == FLASHLOG_ERASED){
+            break;
+        }
+
+        address = (uint16_t)((header[0] << 8) | header[1]);
+        length = header[2];
+        size = flashlog_recordSize(length);
+
+        //The length can't be trusted to find the next record, compact before appending any more
+        if((length == 0) || (length > FLASHLOG_RECORD_DATA) || ((uint32_t)offset + size > pageSize)){
+
+            offset = pageSize;
+            break;
+        }
+
+        logRead(pages[page] + offset + FLASHLOG_RECORD_HEADER,data,length);
+        logRead(pages[page] + offset + size - programSize,commit,programSize);
+
+        //A record which wasn't completely programmed is skipped
+        if(flashlog_committed(commit) && (header[3] == flashlog_check(address,data,length)) &&
+           ((uint32_t)address + length <= imageSize)){
+            memcpy(&image[address],data,length);
+        }
+
+        offset += size;
+    }
+
+    writeOffset = offset;
+}
+
+static uint8_t flashlog_committed(const uint8_t *commit){
+
+    uint8_t i;
+
+    for(i = 0; i < programSize; i++){
+
+        if(commit[i] != FLASHLOG_COMMITTED){
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+static uint8_t flashlog_pageSequence(uint8_t page,uint16_t *pageSequence){
+
+    uint8_t header[4];
+
+    logRead(pages[page],header,4);
+
+    if((header[0] != FLASHLOG_MAGIC_1) || (header[1] != FLASHLOG_MAGIC_2)){
+        return 0;
+    }
+
+    *pageSequence = (uint16_t)((header[2] << 8) | header[3]);
+    return 1;
+}
@@ -0,0 +1,133 @@
+/**
+    @addtogroup COMMON
+* @{
+*/
+
+/**
+    @addtogroup FLASHLOG
+    @brief Append only, wear levelled store for a config region kept in two flash pages.
+    @details Instead of erasing and rewriting a page for every change, each write appends a record
+    of the address, length and changed bytes to the active page. When it is full a compaction pass
+    erases the other page, writes the whole region to it and makes it the active page, so each page
+    is erased once per page full of updates rather than once per update.
+
+    The current values are held in a RAM image of the region, rebuilt from the records by
+    FLASHLOG_init(). FLASHLOG_read() and FLASHLOG_write() have the block function signatures so the
+    store can be given straight to UCCONFIG_setupBlock(), with no on first write erase function:
+
+        FLASHLOG_setup(&flashRead,&flashProgram,&flashErase);
+        FLASHLOG_init(0x0801F800,0x0801FC00,1024,2,image,sizeof(image));
+        UCCONFIG_setupBlock(&FLASHLOG_read,&FLASHLOG_write,&serialWrite);
+
+    Each record is a four byte header (address, length, check byte) and up to #FLASHLOG_RECORD_DATA
+    bytes, padded with #FLASHLOG_ERASED to a multiple of the program size, followed by a program unit
+    which is only programmed once the rest of the record is. A record without it, eg. from a reset
+    while programming, or with a bad check byte is ignored, so each write is kept whole or not at all
+    up to #FLASHLOG_RECORD_DATA bytes.
+
+    Current limitations
+    - Variables aren't at fixed flash addresses, so it can't be used with #UCCONFIG_MEMORY_MAPPED.
+    - The image already is a RAM copy of the region, UCCONFIG_setShadow() isn't needed with it.
+
+    @version 0.1
+    @copyright GNU GPLv3
+    @warning The program and erase functions must complete before returning.
+    @bug None
+    @todo
+
+ * @{
+ */
+
+/*! @file flashLog.h
+    @brief Header file for flashLog library.
+*/
+
+#ifndef FLASH_LOG_H
+#define FLASH_LOG_H
+
+#include <stdint.h>
+
+/*!
+    @brief Maximum number of data bytes in one record.
+*/
+#define FLASHLOG_RECORD_DATA 32
+
+/*!
+    @brief Value of an erased flash byte, also the value of the image before anything is written.
+*/
+#define FLASHLOG_ERASED 0xFF
+
+/*!
+    @brief Error codes returned by function calls
+*/
+typedef enum{
+
+    E_FLASHLOG_NOERROR,         //!<No error.
+    E_FLASHLOG_NOFUNCTION,      //!<FLASHLOG_setup() hasn't been given all three functions.
+    E_FLASHLOG_PROGRAMSIZE,     //!<The program size isn't 1, 2, 4 or 8.
+    E_FLASHLOG_SIZE,            //!<The compacted image and a record don't fit in one page.
+}flashlog_error_t;
+
+/*!
+    @brief Set the functions used to access the two flash pages
+    @param read Function which reads a number of bytes from a flash address.
+    @param program Function which programs a number of bytes, always a multiple of the program size
+    at an address aligned to it, to erased flash.
+    @param erase Function which erases the page starting at the address given.
+*/
+void FLASHLOG_setup(
+        void (*read)(uint32_t address,uint8_t *data,uint16_t length),
+        void (*program)(uint32_t address,const uint8_t *data,uint16_t length),
+        void (*erase)(uint32_t address));
+
+/*!
+    @brief Use two flash pages for the store and rebuild the image from the newest one
+    @details Call after FLASHLOG_setup() and before anything is read or written. Nothing is
+    erased or programmed until the first write.
+    @param pageA Flash address of the first page.
+    @param pageB Flash address of the second page.
+    @param pageSize Size of each page in bytes.
+    @param programSize The smallest unit the flash can program, 1, 2, 4 or 8 bytes.
+    @param image RAM holding the current values of the config region.
+    @param imageSize The size of the config region, addresses 0 to imageSize - 1.
+    @return #E_FLASHLOG_NOERROR if the store can be used.
+*/
+flashlog_error_t FLASHLOG_init(uint32_t pageA,uint32_t pageB,uint16_t pageSize,uint8_t programSize,
+        uint8_t *image,uint16_t imageSize);
+
+/*!
+    @brief Read bytes of the config region from the image
+    @details Addresses outside of the region read as #FLASHLOG_ERASED. Same signature as a block input function.
+    @param address The first address to read.
+    @param data Pointer to where the bytes are stored.
+    @param length The number of bytes to read.
+*/
+void FLASHLOG_read(uint16_t address,uint8_t *data,uint16_t length);
+
+/*!
+    @brief Write bytes of the config region
+    @details Only the span from the first to the last byte which changed is appended, writing the
+    same values costs nothing. Compacts first if the records don't fit in the active page.
+    Addresses outside of the region are ignored. Same signature as a block output function.
+    @param address The first address to write.
+    @param data Pointer to the bytes to write.
+    @param length The number of bytes to write.
+*/
+void FLASHLOG_write(uint16_t address,const uint8_t *data,uint16_t length);
+
+/*!
+    @brief Erase the other page, write the whole image to it and make it the active page
+    @details Called by FLASHLOG_write() when the active page is full, it may also be called when the
+    program has time to spare so a later write doesn't wait for an erase.
+*/
+void FLASHLOG_compact(void);
+
+/*!
+    @brief Get the number of bytes left for records in the active page
+    @return The free bytes, zero before the first write.
+*/
+uint16_t FLASHLOG_free(void);
+
+/**@}*/
+/**@}*/
+#endif
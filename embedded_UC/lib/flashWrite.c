@@ -15,9 +15,12 @@
 */
 
 #include "flashWrite.h"
+#include <string.h>
 
 static void (*out)(uint8_t,uint16_t);
 static uint8_t (*in)(uint16_t);
+static void (*blockOut)(uint16_t,const uint8_t*,uint16_t);
+static void (*blockIn)(uint16_t,uint8_t*,uint16_t);
 
 void FLASHWRITE_setOutput(void (*out_fun)(uint8_t,uint16_t)){
 
@@ -49,137 +52,267 @@ u8_fp_u16 FLASHWRITE_getInput(void){
     return in;
 }
 
-uint16_t FLASHWRITE_write_u8(uint8_t data, uint16_t address){
+void FLASHWRITE_setBlockOutput(void (*out_fun)(uint16_t,const uint8_t*,uint16_t)){
+
+    blockOut = out_fun;
+    return;
+}
+
+void FLASHWRITE_setBlockInput(void (*in_fun)(uint16_t,uint8_t*,uint16_t)){
+
+    blockIn = in_fun;
+    return;
+}
+
+v_fp_u16_cu8p_u16 FLASHWRITE_getBlockOutput(void){
+
+    return blockOut;
+}
+
+v_fp_u16_u8p_u16 FLASHWRITE_getBlockInput(void){
+
+    return blockIn;
+}
+
+uint16_t FLASHWRITE_write_block(const uint8_t *data, uint16_t length, uint16_t address){
+
+    uint16_t i;
+
+    //One call for the whole block if the target supports it
+    if(blockOut != NULL){
+
+        blockOut(address,data,length);
+        return address + length;
+    }
 
-    out((uint8_t)data,address++);
+    for(i = 0; i < length; i++){
+
+        out(data[i],address++);
+    }
     return address;
 }
 
-uint16_t FLASHWRITE_read_u8(uint8_t *data, uint16_t address){
+uint16_t FLASHWRITE_read_block(uint8_t *data, uint16_t length, uint16_t address){
+
+    uint16_t i;
+
+    //One call for the whole block if the target supports it
+    if(blockIn != NULL){
 
-    *data = in(address++);
+        blockIn(address,data,length);
+        return address + length;
+    }
+
+    for(i = 0; i < length; i++){
+
+        data[i] = in(address++);
+    }
     return address;
 }
 
+uint16_t FLASHWRITE_write_u8(uint8_t data, uint16_t address){
+
+    return FLASHWRITE_write_block(&data,1,address);
+}
+
+uint16_t FLASHWRITE_read_u8(uint8_t *data, uint16_t address){
+
+    return FLASHWRITE_read_block(data,1,address);
+}
+
 uint16_t FLASHWRITE_write_8(int8_t data, uint16_t address){
 
-    out(data,address++);
-    return address;
+    uint8_t byte = (uint8_t)data;
+    return FLASHWRITE_write_block(&byte,1,address);
 }
 
 uint16_t FLASHWRITE_read_8(int8_t *data, uint16_t address){
 
-    *data = (int8_t)in(address++);
+    uint8_t byte;
+    address = FLASHWRITE_read_block(&byte,1,address);
+    *data = (int8_t)byte;
     return address;
 }
 
 uint16_t FLASHWRITE_write_c(char data, uint16_t address){
 
-    out(data,address++);
-    return address;
+    uint8_t byte = (uint8_t)data;
+    return FLASHWRITE_write_block(&byte,1,address);
 }
 
 uint16_t FLASHWRITE_read_c(char *data, uint16_t address){
 
-    *data = in(address++);
+    uint8_t byte;
+    address = FLASHWRITE_read_block(&byte,1,address);
+    *data = (char)byte;
     return address;
 }
 
 uint16_t FLASHWRITE_write_u16(uint16_t data, uint16_t address){
 
-    out((uint8_t)(data>>8),address++);
-    out((uint8_t)data,address++);
-    return address;
+    uint8_t bytes[2];
+
+#ifdef FLASHWRITE_NATIVE_ENDIAN
+    memcpy(bytes,&data,2);
+#else
+    bytes[0] = (uint8_t)(data>>8);
+    bytes[1] = (uint8_t)data;
+#endif
+    return FLASHWRITE_write_block(bytes,2,address);
 }
 
 uint16_t FLASHWRITE_read_u16(uint16_t *data, uint16_t address){
 
-    *data = (uint16_t)(in(address++)<<8);
-    *data |= in(address++);
+    uint8_t bytes[2];
+
+    address = FLASHWRITE_read_block(bytes,2,address);
+#ifdef FLASHWRITE_NATIVE_ENDIAN
+    memcpy(data,bytes,2);
+#else
+    *data = (uint16_t)(bytes[0]<<8);
+    *data |= bytes[1];
+#endif
     return address;
 }
 
 uint16_t FLASHWRITE_write_16(int16_t data, uint16_t address){
 
-    out((uint8_t)(data>>8),address++);
-    out((uint8_t)(data),address++);
-    return address;
+    return FLASHWRITE_write_u16((uint16_t)data,address);
 }
 
 uint16_t FLASHWRITE_read_16(int16_t *data, uint16_t address){
 
-    *data = (uint16_t)(in(address++)<<8);
-    *data |= in(address++);
-    return address;
+    return FLASHWRITE_read_u16((uint16_t*)data,address);
 }
+
 uint16_t FLASHWRITE_write_u32(uint32_t data, uint16_t address){
 
-    out((uint8_t)(data>>24),address++);
-    out((uint8_t)(data>>16),address++);
-    out((uint8_t)(data>>8),address++);
-    out((uint8_t)data,address++);
-    return address;
+    uint8_t bytes[4];
+
+#ifdef FLASHWRITE_NATIVE_ENDIAN
+    memcpy(bytes,&data,4);
+#else
+    bytes[0] = (uint8_t)(data>>24);
+    bytes[1] = (uint8_t)(data>>16);
+    bytes[2] = (uint8_t)(data>>8);
+    bytes[3] = (uint8_t)data;
+#endif
+    return FLASHWRITE_write_block(bytes,4,address);
 }
 
 uint16_t FLASHWRITE_read_u32(uint32_t *data, uint16_t address){
 
-    *data = (uint32_t)(in(address++)<<24);
-    *data |= (uint32_t)(in(address++)<<16);
-    *data |= (uint32_t)(in(address++)<<8);
-    *data |= in(address++);
+    uint8_t bytes[4];
+
+    address = FLASHWRITE_read_block(bytes,4,address);
+#ifdef FLASHWRITE_NATIVE_ENDIAN
+    memcpy(data,bytes,4);
+#else
+    *data = (uint32_t)bytes[0]<<24;
+    *data |= (uint32_t)bytes[1]<<16;
+    *data |= (uint32_t)bytes[2]<<8;
+    *data |= bytes[3];
+#endif
     return address;
 }
 
 uint16_t FLASHWRITE_write_32(int32_t data, uint16_t address){
 
-    out((uint8_t)(data>>24),address++);
-    out((uint8_t)(data>>16),address++);
-    out((uint8_t)(data>>8),address++);
-    out((uint8_t)(data),address++);
-    return address;
+    return FLASHWRITE_write_u32((uint32_t)data,address);
 }
 
 uint16_t FLASHWRITE_read_32(int32_t *data, uint16_t address){
 
-    *data = (uint32_t)(in(address++)<<24);
-    *data |= (uint32_t)(in(address++)<<16);
-    *data |= (uint32_t)(in(address++)<<8);
-    *data |= in(address++);
-    return address;
+    return FLASHWRITE_read_u32((uint32_t*)data,address);
 }
 
+#ifndef FLASHWRITE_NO_FLOAT
 uint16_t FLASHWRITE_write_float(float f_data, uint16_t address){
 
-    int32_t data; 
+    return FLASHWRITE_write_u32(FLASHWRITE_from_float(f_data),address);
+}
+
+uint16_t FLASHWRITE_read_float(float *f_data, uint16_t address){
+
+    uint32_t data; 
+    address = FLASHWRITE_read_u32(&data,address);
+
+    *f_data = FLASHWRITE_to_float(data);
+
+    return address;
+}
+
+uint32_t FLASHWRITE_from_float(float f_data){
+
+    uint32_t data;
+
+#ifdef FLASHWRITE_FLOAT_IEEE
+    //The bits themselves, no float arithmetic
+    memcpy(&data,&f_data,4);
+#else
     for(int i = 0; i<MAX_DEC;i++){
 
         f_data *= 10;
     }
 
-    data = (int32_t)f_data;
+    data = (uint32_t)(int32_t)f_data;
+#endif
+    return data;
+}
 
-    out((uint8_t)(data>>24),address++);
-    out((uint8_t)(data>>16),address++);
-    out((uint8_t)(data>>8),address++);
-    out((uint8_t)(data),address++);
-    return address;
+float FLASHWRITE_to_float(uint32_t data){
+
+    float f_data;
+
+#ifdef FLASHWRITE_FLOAT_IEEE
+    memcpy(&f_data,&data,4);
+#else
+    f_data = (int32_t)data;
+
+    for(int i = 0; i<MAX_DEC;i++){
+
+        f_data /= 10;
+    }
+#endif
+    return f_data;
 }
 
-uint16_t FLASHWRITE_read_float(float *f_data, uint16_t address){
+uint16_t FLASHWRITE_write_double(double d_data, uint16_t address){
 
+    uint8_t bytes[8];
 
-    int32_t data; 
-    data = (uint32_t)(in(address++)<<24);
-    data |= (uint32_t)(in(address++)<<16);
-    data |= (uint32_t)(in(address++)<<8);
-    data |= in(address++);
+#ifdef FLASHWRITE_NATIVE_ENDIAN
+    memcpy(bytes,&d_data,8);
+#else
+    uint64_t data;
 
-    *f_data = data;
+    memcpy(&data,&d_data,8);
 
-    for(int i = 0; i<MAX_DEC;i++){
+    for(int i = 0; i < 8; i++){
+
+        bytes[i] = (uint8_t)(data>>(56 - 8*i));
+    }
+#endif
+    return FLASHWRITE_write_block(bytes,8,address);
+}
+
+uint16_t FLASHWRITE_read_double(double *d_data, uint16_t address){
+
+    uint8_t bytes[8];
+
+    address = FLASHWRITE_read_block(bytes,8,address);
+#ifdef FLASHWRITE_NATIVE_ENDIAN
+    memcpy(d_data,bytes,8);
+#else
+    uint64_t data = 0;
+
+    for(int i = 0; i < 8; i++){
 
-        *f_data /= 10;
+        data = (data<<8) | bytes[i];
     }
 
+    memcpy(d_data,&data,8);
+#endif
     return address;
 }
+#endif
@@ -14,8 +14,10 @@
     - **flash_get()** -> Read given data from flash
 
     Current limitations
-    - Maximum float size is limiting to int32 max divided by 10 ^ (MAX_DEC).
-    - Float decimal places are limited by Macro #MAX_DEC.
+    - Maximum float size is limiting to int32 max divided by 10 ^ (MAX_DEC), unless built with #FLASHWRITE_FLOAT_IEEE.
+    - Float decimal places are limited by Macro #MAX_DEC, unless built with #FLASHWRITE_FLOAT_IEEE.
+    - Doubles must be 64 bit IEEE-754, eg. not on AVR.
+    - Defining FLASHWRITE_NO_FLOAT when building leaves out the float and double functions, for targets without an FPU.
 
     @author Stuart Ianna
     @version 0.1
@@ -49,6 +51,11 @@
 */
 typedef void(*v_fp_u8_u16)(uint8_t,uint16_t);
 typedef uint8_t(*u8_fp_u16)(uint16_t);
+/*! 
+    @brief Function pointer typedefs for block output and input functions (address, data, length)
+*/
+typedef void(*v_fp_u16_cu8p_u16)(uint16_t,const uint8_t*,uint16_t);
+typedef void(*v_fp_u16_u8p_u16)(uint16_t,uint8_t*,uint16_t);
 
 /*! 
     @brief Flash a given datatype to the output stream.
@@ -61,7 +68,7 @@ typedef uint8_t(*u8_fp_u16)(uint16_t);
                             int16_t:  FLASHWRITE_write_16,     \
                             uint32_t: FLASHWRITE_write_u32,    \
                             int32_t:  FLASHWRITE_write_32,     \
-                            float:    FLASHWRITE_write_float,  \
+                            FLASHWRITE_PUT_FLOAT               \
                             default:  FLASHWRITE_write_u8      \
                                                           )(DATA,ADDRESS)
 /*! 
@@ -75,15 +82,57 @@ typedef uint8_t(*u8_fp_u16)(uint16_t);
                             int16_t*:  FLASHWRITE_read_16,    \
                             uint32_t*: FLASHWRITE_read_u32,   \
                             int32_t*:  FLASHWRITE_read_32,    \
-                            float*:    FLASHWRITE_read_float, \
+                            FLASHWRITE_GET_FLOAT              \
                             default:  FLASHWRITE_read_u8      \
                                                          )(DATA,ADDRESS)
 
+#ifndef FLASHWRITE_NO_FLOAT
+#define FLASHWRITE_PUT_FLOAT float: FLASHWRITE_write_float, double: FLASHWRITE_write_double,
+#define FLASHWRITE_GET_FLOAT float*: FLASHWRITE_read_float, double*: FLASHWRITE_read_double,
+#else
+#define FLASHWRITE_PUT_FLOAT
+#define FLASHWRITE_GET_FLOAT
+#endif
+
 /*! 
     @brief Maximum number of decimal places a float will contain.
 */
 #define MAX_DEC 4
 
+/*! 
+    @brief Storage format with multi byte values most significant byte first.
+*/
+#define FLASHWRITE_FORMAT_BIG_ENDIAN 0
+/*! 
+    @brief Storage format with multi byte values least significant byte first.
+*/
+#define FLASHWRITE_FORMAT_LITTLE_ENDIAN 1
+
+/*! 
+    @brief Storage format flag set when floats are stored as their IEEE-754 bits, added to the byte order.
+*/
+#define FLASHWRITE_FORMAT_FLOAT_IEEE 2
+
+#ifdef FLASHWRITE_FLOAT_IEEE
+#define FLASHWRITE_FORMAT_FLOAT FLASHWRITE_FORMAT_FLOAT_IEEE
+#else
+#define FLASHWRITE_FORMAT_FLOAT 0
+#endif
+
+/*! 
+    @brief The storage format of multi byte values, reported to the PC by UCConfig.
+    @details Values are stored big endian, unless FLASHWRITE_NATIVE_ENDIAN is defined when building,
+    then they are copied as the CPU holds them with memcpy(). Floats are stored as an int32_t scaled by
+    10^#MAX_DEC, unless FLASHWRITE_FLOAT_IEEE is defined when building, then their 32 bits are stored
+    like a uint32_t. Doubles are always stored as their 64 bits. Flash written in one format can't be
+    read in another.
+*/
+#if defined(FLASHWRITE_NATIVE_ENDIAN) && !(defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__))
+#define FLASHWRITE_FORMAT (FLASHWRITE_FORMAT_LITTLE_ENDIAN | FLASHWRITE_FORMAT_FLOAT)
+#else
+#define FLASHWRITE_FORMAT (FLASHWRITE_FORMAT_BIG_ENDIAN | FLASHWRITE_FORMAT_FLOAT)
+#endif
+
 
 /*! 
     @brief Set the target output stream for flash_put functions
@@ -115,6 +164,50 @@ v_fp_u8_u16 FLASHWRITE_getOutput(void);
     @return Function pointer to input stream or Null if not defined.
 */
 u8_fp_u16 FLASHWRITE_getInput(void);
+/*! 
+    @brief Set a block output stream for flash_put functions (optional)
+    @details When set every write goes through this function in one call, eg. a page write to an
+    EEPROM, instead of one call to the output stream per byte. Set to NULL to use the output stream.
+    @param out Pointer to the block output function, given the first address, the bytes and their number.
+    @return none.
+*/
+void FLASHWRITE_setBlockOutput(void (*out)(uint16_t address,const uint8_t *data,uint16_t length));
+/*! 
+    @brief Set a block input stream for flash_get functions (optional)
+    @details When set every read goes through this function in one call instead of one call to the
+    input stream per byte. Set to NULL to use the input stream.
+    @param in Pointer to the block input function, given the first address, where to store the bytes and their number.
+    @return none.
+*/
+void FLASHWRITE_setBlockInput(void (*in)(uint16_t address,uint8_t *data,uint16_t length));
+/*! 
+    @brief Get the current block output stream
+    @return Function pointer to block output stream or Null if not defined.
+*/
+v_fp_u16_cu8p_u16 FLASHWRITE_getBlockOutput(void);
+/*! 
+    @brief Get the current block input stream
+    @return Function pointer to block input stream or Null if not defined.
+*/
+v_fp_u16_u8p_u16 FLASHWRITE_getBlockInput(void);
+/*! 
+    @brief Write a number of bytes starting at the address given
+    @details Uses the block output stream if set, otherwise the output stream one byte at a time.
+    @param data Pointer to the bytes to be written
+    @param length The number of bytes to write
+    @param address The address of the first byte
+    @return The memory address given plus length.
+*/
+uint16_t FLASHWRITE_write_block(const uint8_t *data, uint16_t length, uint16_t address);
+/*! 
+    @brief Read a number of bytes starting at the address given
+    @details Uses the block input stream if set, otherwise the input stream one byte at a time.
+    @param data The container to store the read bytes
+    @param length The number of bytes to read
+    @param address The address of the first byte
+    @return The memory address given plus length.
+*/
+uint16_t FLASHWRITE_read_block(uint8_t *data, uint16_t length, uint16_t address);
 
 /*! 
     @brief Write a unsigned 8 bit integer to address given
@@ -235,6 +328,7 @@ uint16_t FLASHWRITE_write_32(int32_t data, uint16_t address);
     @return The memory address given plus one.
 */
 uint16_t FLASHWRITE_read_32(int32_t *data, uint16_t address);
+#ifndef FLASHWRITE_NO_FLOAT
 /*! 
     @brief Write a float to address given
     @details This function is invoked by macro definition flash_put
@@ -253,6 +347,39 @@ uint16_t FLASHWRITE_write_float(float data, uint16_t address);
 */
 uint16_t FLASHWRITE_read_float(float *data, uint16_t address);
 
+/*! 
+    @brief Write a double to address given, as its 64 bits in the storage byte order
+    @details This function is invoked by macro definition flash_put
+    @param data The data to be written
+    @param address The address to be written to
+    @return The memory address given plus eight.
+*/
+uint16_t FLASHWRITE_write_double(double data, uint16_t address);
+
+/*! 
+    @brief Read a double from address given
+    @details This function is invoked by macro definition flash_get
+    @param data The container to store the read data
+    @param address The address to read from 
+    @return The memory address given plus eight.
+*/
+uint16_t FLASHWRITE_read_double(double *data, uint16_t address);
+
+/*! 
+    @brief Convert a float to the 32 bits stored for it, see #FLASHWRITE_FORMAT
+    @param data The float to convert.
+    @return The value written like a uint32_t.
+*/
+uint32_t FLASHWRITE_from_float(float data);
+
+/*! 
+    @brief Convert the 32 bits stored for a float back to the float
+    @param stored The value read like a uint32_t.
+    @return The float.
+*/
+float FLASHWRITE_to_float(uint32_t stored);
+#endif
+
 /**@}*/
 /**@}*/
 
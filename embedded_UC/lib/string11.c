@@ -16,7 +16,31 @@
 
 #include "string11.h"
 
+//Called by every print function, the output function or string11_put() when buffering
 static void (*out)(uint8_t);
+static void (*string11_fp_out)(uint8_t);
+static void (*string11_fp_blockOut)(const uint8_t *data,uint16_t length);
+static uint8_t *string11_buffer;
+static uint16_t string11_bufferSize;
+static uint16_t string11_bufferLength;
+
+//Add a character to the buffer, sending it when full
+static void string11_put(uint8_t x);
+//Point out at the buffer if there is one and a block output, otherwise at the output function
+static void string11_select(void);
+
+//The two digits of every number from 0 to 99
+static const char string11_digits[200] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
 
 int32_t str2int(char *buffer){
 
@@ -73,6 +97,7 @@ uint32_t str2uint(char *buffer){
     return number;
 }
 
+#ifndef STRING11_NO_FLOAT
 float str2float(char *buffer){
 
     uint8_t isMinus = 0;
@@ -118,48 +143,138 @@ float str2float(char *buffer){
 
     return number;
 }
+#endif
+
+uint8_t u32toa(uint32_t x, char *buffer){
+
+    uint8_t length = 1;
+    uint32_t bound = 10;
+    uint32_t quotient;
+    uint8_t pair;
+
+    //Count the digits first so they can be written from the last one back
+    while((length < 10) && (x >= bound)){
+
+        length++;
+        bound *= 10;
+    }
+
+    buffer += length;
+    *buffer = 0;
+
+    while(x >= 100){
+
+        quotient = x/100;
+        pair = (uint8_t)(x - quotient*100)*2;
+        x = quotient;
+
+        *--buffer = string11_digits[pair + 1];
+        *--buffer = string11_digits[pair];
+    }
+
+    if(x >= 10){
+
+        *--buffer = string11_digits[x*2 + 1];
+        *--buffer = string11_digits[x*2];
+    }
+    else{
+
+        *--buffer = (char)(x + 48);
+    }
+
+    return length;
+}
 
 void STRING11_setOutput(void (*out_fun)(uint8_t)){
 
-    out = out_fun;
+    string11_fp_out = out_fun;
+    string11_select();
     return;
 }
 
 v_fp_u8 STRING11_getOutput(void){
 
-    if(out == NULL){
+    return string11_fp_out;
+}
 
-        return NULL;
-    }
-    return out;
+void STRING11_setBlockOutput(void (*out_fun)(const uint8_t *data,uint16_t length)){
+
+    STRING11_flush();
+    string11_fp_blockOut = out_fun;
+    string11_select();
 }
 
-void print_c(char x){
+v_fp_cu8p_u16 STRING11_getBlockOutput(void){
 
-    out((char)(x));
+    return string11_fp_blockOut;
 }
 
-void print_u8(uint8_t x){
+void STRING11_setBuffer(uint8_t *buffer,uint16_t size){
+
+    STRING11_flush();
+    string11_buffer = buffer;
+    string11_bufferSize = size;
+    string11_select();
+}
 
-    if(x < 10){
+uint8_t *STRING11_getBuffer(uint16_t *size){
 
-        out(x+48);
+    *size = string11_bufferSize;
+    return string11_buffer;
+}
+
+void STRING11_flush(void){
+
+    if(string11_bufferLength == 0){
         return;
     }
-    if(x < 100){
 
-        out((uint8_t)(x/10) + 48);
-        out(x%10 + 48);
-        return;
+    string11_fp_blockOut(string11_buffer,string11_bufferLength);
+    string11_bufferLength = 0;
+}
+
+static void string11_put(uint8_t x){
+
+    string11_buffer[string11_bufferLength++] = x;
+
+    if(string11_bufferLength == string11_bufferSize){
+
+        STRING11_flush();
+    }
+}
+
+static void string11_select(void){
+
+    if((string11_buffer != NULL) && (string11_bufferSize > 0) && (string11_fp_blockOut != NULL)){
+
+        out = string11_put;
     }
     else{
 
+        out = string11_fp_out;
+    }
+}
+
+void print_c(char x){
+
+    out((char)(x));
+}
+
+void print_u8(uint8_t x){
+
+    if(x >= 100){
+
         out((uint8_t)(x/100) + 48);
         x = x%100;
-        out((uint8_t)(x/10) + 48);
-        out(x%10 + 48);
+        out(string11_digits[x*2]);
+        out(string11_digits[x*2 + 1]);
         return;
     }
+    if(x >= 10){
+
+        out(string11_digits[x*2]);
+    }
+    out(string11_digits[x*2 + 1]);
 }
 
 void print_8(int8_t x){
@@ -177,27 +292,7 @@ void print_8(int8_t x){
 
 void print_u16(uint16_t x){
 
-    uint16_t top = 10000;
-    uint16_t mod;
-    uint8_t printed = 0;
-
-    if(x == 0){
-
-        out((char)'0');
-        return;
-    }
-
-    while(top){
-
-        mod = x/top;
-        if(mod || printed){
-            out((uint8_t)(mod+48));
-            printed = 1;
-        }
-        x = x % top;
-        top /= 10;
-    }
-    return;
+    print_u32(x);
 }
 
 void print_16(int16_t x){
@@ -216,26 +311,12 @@ void print_16(int16_t x){
 
 void print_u32(uint32_t x){
 
-    uint32_t top = 1000000000;
-    uint32_t mod;
-    uint8_t printed = 0;
-
-    if(x == 0){
+    char buffer[11];
+    uint8_t length = u32toa(x,buffer);
 
-        out((char)'0');
-            printed = 1;
-        return;
-    }
+    for(uint8_t i = 0; i < length; i++){
 
-    while(top){
-
-        mod = x/top;
-        if(mod || printed){
-            out((uint8_t)(mod+48));
-            printed = 1;
-        }
-        x = x % top;
-        top /= 10;
+        out((uint8_t)buffer[i]);
     }
     return;
 }
@@ -255,6 +336,7 @@ void print_32(int32_t x){
 
 }
 
+#ifndef STRING11_NO_FLOAT
 void print_f(float x){
 
     if(x < 0){
@@ -280,6 +362,7 @@ void print_f(float x){
     }
 
 }
+#endif
 
 void print_s(char *x){
 
@@ -334,11 +417,13 @@ void prints_32(int32_t x){
     print_c((char)' ');
 }
 
+#ifndef STRING11_NO_FLOAT
 void prints_f(float x){
 
     print_f(x);
     print_c((char)' ');
 }
+#endif
 
 void prints_s(char *x){
 
@@ -389,11 +474,13 @@ void printc_32(int32_t x){
     print_c((char)',');
 }
 
+#ifndef STRING11_NO_FLOAT
 void printc_f(float x){
 
     print_f(x);
     print_c((char)',');
 }
+#endif
 
 void printc_s(char *x){
 
@@ -451,12 +538,14 @@ void printl_32(int32_t x){
     print_c((char)'\r');
 }
 
+#ifndef STRING11_NO_FLOAT
 void printl_f(float x){
 
     print_f(x);
     print_c((char)'\n');
     print_c((char)'\r');
 }
+#endif
 
 void printl_s(char *x){
 
@@ -508,11 +597,13 @@ void printt_32(int32_t x){
     print_c((char)'\t');
 }
 
+#ifndef STRING11_NO_FLOAT
 void printt_f(float x){
 
     print_f(x);
     print_c((char)'\t');
 }
+#endif
 
 void printt_s(char *x){
 
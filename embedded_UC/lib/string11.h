@@ -19,7 +19,7 @@
     Current limitations
     - Maximum float size is limiting to uint32 max / 10^MAX_DEC.
     - Float decimal places are limited by Macro #MAX_DEC
-    - Optimizations could be done on some functions.
+    - Defining STRING11_NO_FLOAT when building leaves out the float functions, for targets without an FPU.
 
     @author Stuart Ianna
     @version 0.2
@@ -53,6 +53,19 @@
     @brief Function pointer typedef for void function with uint8_t parameter
 */
 typedef void(*v_fp_u8)(uint8_t);
+/*! 
+    @brief Function pointer typedef for a block output function (data, length)
+*/
+typedef void(*v_fp_cu8p_u16)(const uint8_t*,uint16_t);
+
+/*! 
+    @brief The float association of the print macros, left out with STRING11_NO_FLOAT.
+*/
+#ifndef STRING11_NO_FLOAT
+#define STRING11_FLOAT(F) float: F,
+#else
+#define STRING11_FLOAT(F)
+#endif
 
 /*! 
     @brief Print a given datatype to the output stream.
@@ -65,7 +78,7 @@ typedef void(*v_fp_u8)(uint8_t);
                     int16_t:    print_16,   \
                     uint32_t:   print_u32,  \
                     int32_t:    print_32,   \
-                    float:      print_f,    \
+                    STRING11_FLOAT(print_f) \
                     int:        print_32,   \
                     char*:      print_s,    \
                     default:    print_c     \
@@ -82,7 +95,7 @@ typedef void(*v_fp_u8)(uint8_t);
                     int16_t:    prints_16,  \
                     uint32_t:   prints_u32, \
                     int32_t:    prints_32,  \
-                    float:      prints_f,   \
+                    STRING11_FLOAT(prints_f)\
                     int:        prints_32,  \
                     char*:      prints_s,   \
                     default:    prints_c    \
@@ -98,7 +111,7 @@ typedef void(*v_fp_u8)(uint8_t);
                     int16_t:    printc_16,  \
                     uint32_t:   printc_u32, \
                     int32_t:    printc_32,  \
-                    float:      printc_f,   \
+                    STRING11_FLOAT(printc_f)\
                     int:        printc_32,  \
                     char*:      printc_s,   \
                     default:    printc_c    \
@@ -115,7 +128,7 @@ typedef void(*v_fp_u8)(uint8_t);
                     int16_t:    printl_16,  \
                     uint32_t:   printl_u32, \
                     int32_t:    printl_32,  \
-                    float:      printl_f,   \
+                    STRING11_FLOAT(printl_f)\
                     int:        printl_32,  \
                     char*:      printl_s,   \
                     default:    printl_c    \
@@ -132,7 +145,7 @@ typedef void(*v_fp_u8)(uint8_t);
                     int16_t:    printt_16,  \
                     uint32_t:   printt_u32, \
                     int32_t:    printt_32,  \
-                    float:      printt_f,   \
+                    STRING11_FLOAT(printt_f)\
                     int:        printt_32,  \
                     char*:      printt_s,   \
                     default:    printt_c    \
@@ -155,12 +168,23 @@ int32_t str2int(char *buffer);
     @return The parsed integer, returns 0 if contained invalid characters.
 */
 uint32_t str2uint(char *buffer);
+#ifndef STRING11_NO_FLOAT
 /*! 
     @brief Convert a null terminated string to a float.
     @param buffer Character array containing the number
     @return The parsed integer, returns 0 if contained invalid characters.
 */
 float str2float(char *buffer);
+#endif
+
+/*! 
+    @brief Convert an unsigned integer to a null terminated string of decimal digits.
+    @details Digits are produced two at a time from a table, one division by 100 per pair.
+    @param x The number to convert.
+    @param buffer Character array of at least 11 bytes.
+    @return The number of digits written, not counting the null.
+*/
+uint8_t u32toa(uint32_t x, char *buffer);
 
 /*! 
     @brief Set the target output stream for print functions
@@ -176,6 +200,47 @@ void STRING11_setOutput(void (*out)(uint8_t));
 */
 v_fp_u8 STRING11_getOutput(void);
 
+/*! 
+    @brief Set a block output for print functions, used with a buffer (optional)
+    @details With both a block output and a buffer set, printed characters are collected in the
+    buffer and sent with one call when it is full or STRING11_flush() is called, eg. so a whole
+    message goes in one DMA transfer. Otherwise each character goes to the output set by
+    STRING11_setOutput(). Anything already buffered is flushed first.
+    @param out Pointer to a function which sends length bytes, NULL to stop buffering.
+    The bytes must have been sent or copied when it returns, the buffer is reused straight away.
+    @return none.
+*/
+void STRING11_setBlockOutput(void (*out)(const uint8_t *data,uint16_t length));
+
+/*! 
+    @brief Get the current block output
+    @return Function pointer to the block output or Null if not defined.
+*/
+v_fp_cu8p_u16 STRING11_getBlockOutput(void);
+
+/*! 
+    @brief Set the RAM buffer used with the block output (optional)
+    @details Anything already buffered is flushed first.
+    @param buffer Pointer to the buffer, NULL to stop buffering.
+    @param size The size of the buffer in bytes.
+    @return none.
+*/
+void STRING11_setBuffer(uint8_t *buffer,uint16_t size);
+
+/*! 
+    @brief Get the current buffer
+    @param size Pointer to where the size of the buffer is stored.
+    @return Pointer to the buffer or Null if not defined.
+*/
+uint8_t *STRING11_getBuffer(uint16_t *size);
+
+/*! 
+    @brief Send everything in the buffer to the block output
+    @details Does nothing if the buffer is empty or not used.
+    @return none.
+*/
+void STRING11_flush(void);
+
 /*! 
     @brief Send a character to the output stream. Implemented internally.
     @details This function is called by macro defined _Generic.
@@ -225,6 +290,7 @@ void print_u32(uint32_t x);
     @return none.
 */
 void print_32(int32_t x);
+#ifndef STRING11_NO_FLOAT
 /*! 
     @brief Send a float to the output stream. Implemented internally.
     @details This function is called by macro defined _Generic.
@@ -232,6 +298,7 @@ void print_32(int32_t x);
     @return none.
 */
 void print_f(float x);
+#endif
 /*! 
     @brief Send a string literal to the output stream. Implemented internally.
     @details This function is called by macro defined _Generic.
@@ -288,6 +355,7 @@ void prints_u32(uint32_t x);
     @return none.
 */
 void prints_32(int32_t x);
+#ifndef STRING11_NO_FLOAT
 /*! 
     @brief Send a float plus a space to the output stream. Implemented internally.
     @details This function is called by macro defined _Generic.
@@ -295,6 +363,7 @@ void prints_32(int32_t x);
     @return none.
 */
 void prints_f(float x);
+#endif
 /*! 
     @brief Send a string literal plus a space to the output stream. Implemented internally.
     @details This function is called by macro defined _Generic.
@@ -351,6 +420,7 @@ void printt_u32(uint32_t x);
     @return none.
 */
 void printt_32(int32_t x);
+#ifndef STRING11_NO_FLOAT
 /*! 
     @brief Send a float plus a tab to the output stream. Implemented internally.
     @details This function is called by macro defined _Generic.
@@ -358,6 +428,7 @@ void printt_32(int32_t x);
     @return none.
 */
 void printt_f(float x);
+#endif
 /*! 
     @brief Send a string literal plus a tab to the output stream. Implemented internally.
     @details This function is called by macro defined _Generic.
@@ -414,6 +485,7 @@ void printc_u32(uint32_t x);
     @return none.
 */
 void printc_32(int32_t x);
+#ifndef STRING11_NO_FLOAT
 /*! 
     @brief Send a float plus a comma to the output stream. Implemented internally.
     @details This function is called by macro defined _Generic.
@@ -421,6 +493,7 @@ void printc_32(int32_t x);
     @return none.
 */
 void printc_f(float x);
+#endif
 /*! 
     @brief Send a string literal plus a comma to the output stream. Implemented internally.
     @details This function is called by macro defined _Generic.
@@ -477,6 +550,7 @@ void printl_u32(uint32_t x);
     @return none.
 */
 void printl_32(int32_t x);
+#ifndef STRING11_NO_FLOAT
 /*! 
     @brief Send a float plus a new line to the output stream. Implemented internally.
     @details This function is called by macro defined _Generic.
@@ -484,6 +558,7 @@ void printl_32(int32_t x);
     @return none.
 */
 void printl_f(float x);
+#endif
 /*! 
     @brief Send a string literal plus a new line to the output stream. Implemented internally.
     @details This function is called by macro defined _Generic.
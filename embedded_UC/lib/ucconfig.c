@@ -1,4 +1,6 @@
 #include "ucconfig.h"
+#include <string.h>
+#include <stdatomic.h>
 
 //Flash read function pointer
 static uint8_t (*ucconfig_fp_flashRead)(uint16_t address);
@@ -6,9 +8,17 @@ static uint8_t (*ucconfig_fp_flashRead)(uint16_t address);
 //Flash write function pointer
 static void (*ucconfig_fp_flashWrite)(uint8_t byte,uint16_t address);
 
+//Flash block read and write function pointers, used instead of the byte ones when set
+static void (*ucconfig_fp_blockRead)(uint16_t address,uint8_t *data,uint16_t length);
+static void (*ucconfig_fp_blockWrite)(uint16_t address,const uint8_t *data,uint16_t length);
+
 //Serial write function pointer
 static void (*ucconfig_fp_serialWrite)(uint8_t byte);
 
+//Serial block write function pointer, each response frame is collected in txBuffer and sent with one call
+static void (*ucconfig_fp_serialBlock)(const uint8_t *data,uint16_t length);
+static uint8_t ucconfig_txBuffer[UCCONFIG_TX_BUFFER_SIZE];
+
 //Config mode exit function pointer
 static void (*ucconfig_fp_onExit)(void);
 
@@ -18,48 +28,257 @@ static void (*ucconfig_fp_onEnter)(void);
 //Config mode first write function pointer
 static void (*ucconfig_fp_onFirstWrite)(void);
 
+//Region CRC function pointer, defaults to ucconfig_crc32()
+static uint32_t (*ucconfig_fp_crc)(uint16_t address,uint16_t length);
+
+//Baud rate change function pointer
+static uint8_t (*ucconfig_fp_setBaud)(uint32_t baud);
+
+//Baud rates of the application, the session and the one before the last change
+static uint32_t ucconfig_defaultBaud;
+static uint32_t ucconfig_baud;
+static uint32_t ucconfig_previousBaud;
+
+//Last baud rate the set baud function didn't support, so its confirmation is refused
+static uint32_t ucconfig_refusedBaud;
+
+//Idle loops left for the PC to confirm a new baud rate, zero if nothing to confirm
+static uint16_t ucconfig_baudConfirm;
+
+//Millisecond clock for UCCONFIG_loop(), it blocks while active without one
+static uint32_t (*ucconfig_fp_clock)(void);
+
+//Times in ms of the current poll, the last received byte and the last baud change
+static uint32_t ucconfig_now;
+static uint32_t ucconfig_lastReceived;
+static uint32_t ucconfig_baudChanged;
+
+//A flash page held in the staging buffer, bytes from dirtyStart up to dirtyEnd differ from flash
+typedef struct{
+    uint16_t address;
+    uint16_t dirtyStart;
+    uint16_t dirtyEnd;
+    uint8_t used;
+}ucconfig_stage_t;
+
+//Staging buffer set by UCCONFIG_setStaging(), split into stageCount pages
+static uint8_t *ucconfig_stagingBuffer;
+static uint16_t ucconfig_pageSize;
+static uint8_t ucconfig_stageCount;
+static uint8_t ucconfig_nextEvict;
+static ucconfig_stage_t ucconfig_stages[UCCONFIG_STAGING_MAX_PAGES];
+
+//Flash geometry set by UCCONFIG_setGeometry(), a page which isn't blank is erased before a staged page is written
+static void (*ucconfig_fp_pageErase)(uint16_t address);
+static uint8_t ucconfig_erasedValue;
+
+//RAM copy of flash from shadowAddress set by UCCONFIG_setShadow(), kept up to date by every flash write
+static uint8_t *ucconfig_shadow;
+static uint16_t ucconfig_shadowAddress;
+static uint16_t ucconfig_shadowSize;
+
+//A/B banks set by UCCONFIG_setBanks(), addresses below bankSize are mapped to ucconfig_bank
+static uint16_t ucconfig_banks[2];
+static uint16_t ucconfig_bankSize;
+static void (*ucconfig_fp_bankErase)(uint16_t address,uint16_t length);
+
+//Bank holding the config in use and its version, accesses go to the other bank once a session writes
+static uint8_t ucconfig_activeBank;
+static uint8_t ucconfig_bank;
+static uint16_t ucconfig_bankVersion;
+
+//Application STRING11 and flashWrite function pointers, stored while in config mode
+static v_fp_u8 ucconfig_saved_print;
+static v_fp_u8_u16 ucconfig_saved_flashWrite;
+static u8_fp_u16 ucconfig_saved_flashRead;
+static v_fp_u16_cu8p_u16 ucconfig_saved_blockWrite;
+static v_fp_u16_u8p_u16 ucconfig_saved_blockRead;
+static v_fp_cu8p_u16 ucconfig_saved_printBlock;
+static uint8_t *ucconfig_saved_printBuffer;
+static uint16_t ucconfig_saved_printBufferSize;
+
 //Keep track of number of varaibles written, used to determine when to call firstWrite FP
 static uint16_t ucconfig_written;
 
-//True if in active config mode
-static uint16_t ucconfig_activeMode;
+//Bytes programmed this session, bytes which already held the value aren't programmed
+static uint32_t ucconfig_programmed;
+
+//Config mode session, shared with the listen context
+typedef enum{
+    UCCONFIG_SESSION_IDLE,      //Matching the key, set by the consumer
+    UCCONFIG_SESSION_KEYED,     //Key received, set by the listen context, bytes are queued from now on
+    UCCONFIG_SESSION_ACTIVE,    //Started by the consumer with ucconfig_active()
+}ucconfig_session_t;
+
+//The listen context only moves it from idle to keyed, every other change is made by the consumer
+static atomic_uint_fast8_t ucconfig_session;
+
+//Counts the bytes queued by the listen context, only it writes this so no read-modify-write is shared
+//The consumer restarts the timeout when it differs from receivedSeen
+static atomic_uint_fast8_t ucconfig_received;
+static uint8_t ucconfig_receivedSeen;
+
+//Idle UCCONFIG_loop() iterations left before config mode times out
+static uint16_t ucconfig_idleLoops;
+
+//Sequence character of the frame being parsed, NULL if it didn't have one
+static uint8_t ucconfig_sequence = UCCONFIG_NULL;
+
+//Position in a frame of the next byte to be parsed
+typedef enum{
+    UCCONFIG_STATE_COMMAND,     //Waiting for a command character
+    UCCONFIG_STATE_SEQUENCE,    //NULL or sequence character
+    UCCONFIG_STATE_TYPE,        //Data type character
+    UCCONFIG_STATE_LENGTH,      //Data length character
+    UCCONFIG_STATE_NOT_USED_1,  //First not used character
+    UCCONFIG_STATE_NOT_USED_2,  //Second not used character
+    UCCONFIG_STATE_DATA,        //Data characters
+    UCCONFIG_STATE_NULL,        //NULL following data
+    UCCONFIG_STATE_FRAME_END,   //Frame end character
+    UCCONFIG_STATE_SKIP,        //Frame was invalid, ignore bytes until the frame end
+}ucconfig_state_t;
+
+//A frame being received, filled in one byte at a time by ucconfig_parseByte()
+typedef struct{
+    uint8_t command;
+    uint8_t type;
+    uint8_t length;
+    uint8_t received;
+    char data[UCCONFIG_BULK_MAX_LENGTH + 1];
+}ucconfig_frame_t;
+
+static ucconfig_state_t ucconfig_state;
+static ucconfig_frame_t ucconfig_frame;
 
 //Flash memory pointers
 static uint16_t ucconfig_memPointer;
 static uint16_t ucconfig_memPointerOffset;
 
-//FIFO used for serial communication
-static FIFO8 ucconfig_fifo;
+//FIFO used for serial communication, filled by UCCONFIG_listen() and emptied by UCCONFIG_loop()
+static FIFO8_SPSC ucconfig_fifo;
 static uint8_t ucconfig_fifo_buffer[UCCONFIG_FIFO_SIZE];
 
-static void ucconfig_checkKey(uint8_t byte);
+//Number of key characters matched so far by UCCONFIG_listen()
+static uint8_t ucconfig_keyPos;
 
-//Main config loop, gets triggered by ucconfig_checkKey when a valid key is found
-//The UC is 'Trapped' in this while(1) loop until a terminate command is sent or timeout occurs
+//Start config mode once UCCONFIG_listen() has found the key, called by the consumer
+//Switches the outputs, acknowledges the key and calls the on enter function
 static void ucconfig_active(void);
+//Returns 1 if the listen context queued anything since the last call
+static uint8_t ucconfig_newBytes(void);
 
 //Determine if it is the first byte write operation
 static void ucconfig_call_if_first(void);
 
-//Determine which command (if any) was sent
-static void ucconfig_parseCommand();
+//Parse one received byte, a command is run as soon as its frame end is parsed
+static void ucconfig_parseByte(uint8_t byte);
+
+//Returns 1 if the byte is a command character
+static uint8_t ucconfig_isCommand(uint8_t byte);
+
+//Run the command of a complete frame
+static void ucconfig_runCommand(void);
+
+//The frame being received is invalid, respond and ignore the rest of it
+static void ucconfig_frameError(void);
+
+//Store the character following a command, returns 0 if it isn't NULL or a sequence
+static uint8_t ucconfig_readSequence(uint8_t byte);
+
+//Returns 1 if the frame has no type and between 1 and maxLength decimal characters of data
+static uint8_t ucconfig_digits(uint8_t maxLength);
 
 //A successful write data command was sent
 static void ucconfig_write_data();
+//A successful bulk write data command was sent
+static void ucconfig_bulk_write_data();
 //A successful read data command was sent
 static void ucconfig_read_data();
+//A successful read block command was sent
+static void ucconfig_read_block();
+//A successful CRC command was sent
+static void ucconfig_crc_block();
+//A successful set baud command was sent
+static void ucconfig_set_baud();
+//Switch the baud rate back to the given rate
+static void ucconfig_restoreBaud(uint32_t baud);
+//Get the byte count of a read block or CRC frame, returns 0 if the frame is invalid
+static uint16_t ucconfig_read_count(void);
+//Default CRC-32 of a memory region, read one byte at a time through flashWrite
+static uint32_t ucconfig_crc32(uint16_t address,uint16_t length);
+//A successful commit command was sent
+static void ucconfig_commit();
+//A successful format command was sent
+static void ucconfig_format();
+
+//A successful rollback command was sent
+static void ucconfig_rollback();
+//Responds with the number of bytes programmed this session
+static void ucconfig_stats();
+
+//The flash address of a config address, in the bank accesses currently go to
+static uint16_t ucconfig_bankAddress(uint16_t address);
+//Returns 1 and the version if a bank has a valid footer and CRC
+static uint8_t ucconfig_bankValid(uint8_t bank,uint16_t *version);
+//CRC-32 of the data of a bank
+static uint32_t ucconfig_bankCrc(uint8_t bank);
+//Start writing the other bank as a copy of the active one
+static void ucconfig_bankBegin(void);
+//Make the bank written this session the active one
+static void ucconfig_bankCommit(void);
+//Add bytes to a CRC-32
+static uint32_t ucconfig_crcUpdate(uint32_t crc,const uint8_t *data,uint16_t length);
+//Read and write flash addresses without mapping them to a bank
+static void ucconfig_rawRead(uint16_t address,uint8_t *data,uint16_t length);
+static void ucconfig_rawWrite(uint16_t address,const uint8_t *data,uint16_t length);
+
+//The value of a 16, 32 bit or double variable from its bytes as stored in flash, see #FLASHWRITE_FORMAT
+static uint16_t ucconfig_stored16(const uint8_t *bytes);
+static uint32_t ucconfig_stored32(const uint8_t *bytes);
+#ifndef UCCONFIG_NO_FLOAT
+static double ucconfig_storedDouble(const uint8_t *bytes);
+#endif
+//Flash output and input used while staging
+static void ucconfig_stageWrite(uint8_t byte,uint16_t address);
+static uint8_t ucconfig_stageRead(uint16_t address);
+//Returns the staged page holding an address, or UCCONFIG_STAGING_MAX_PAGES if it isn't staged
+static uint8_t ucconfig_stageFind(uint16_t address);
+//Read and write flash directly, through the block functions if there are any
+//Writes only program the runs of bytes which differ from what is stored
+static void ucconfig_flashReadBlock(uint16_t address,uint8_t *data,uint16_t length);
+static void ucconfig_flashWriteBlock(uint16_t address,const uint8_t *data,uint16_t length);
+//Program a run of changed bytes, mapped to a bank and kept in the shadow
+static void ucconfig_flashProgram(uint16_t address,const uint8_t *data,uint16_t length);
+//Returns the shadow copy of length bytes at address, or NULL if they aren't all shadowed
+static const uint8_t *ucconfig_shadowBytes(uint16_t address,uint16_t length);
+//Read bytes for UCCONFIG_get() and UCCONFIG_read(), from the shadow or mapped to the active bank
+static void ucconfig_getBytes(uint16_t address,uint8_t *data,uint16_t length);
+//Read the shadow again from flash, after flash changed other than through ucconfig_flashWriteBlock()
+static void ucconfig_shadowLoad(void);
+//Copy bytes being written to flash into the part of the shadow they overlap
+static void ucconfig_shadowWrite(uint16_t address,const uint8_t *data,uint16_t length);
+//Write one staged page to flash and free it
+static void ucconfig_stageFlush(uint8_t page);
+//Returns 1 if flash can be changed to the staged bytes without an erase, each byte is already the same or erased
+static uint8_t ucconfig_pageBlank(uint16_t address,const uint8_t *data,uint16_t length);
+//Erase the flash page of a staged page and program the staged copy of it
+static void ucconfig_pageRewrite(uint8_t page);
+//Write every staged page to flash
+static void ucconfig_stageCommit(void);
 //A successful set address command was sent
 static void ucconfig_set_address();
 //A successful get address command was sent
 static void ucconfig_get_address();
-//Exits from config mode
+//Exits from config mode if the frame is valid
 static void ucconfig_terminate();
+//Restores module outputs and leaves config mode, used by terminate and timeout
+static void ucconfig_exit(void);
 //Sent not acknowledge
 static void ucconfig_sendNack();
 //Sent acknowledge
 static void ucconfig_sendAck();
-//Sent not acknowledge
-static void ucconfig_sendNack();
+//End a response frame with a new line and send it
+static void ucconfig_endFrame(void);
 
 //Send given data types back to PC when requested by read_data
 static void ucconfig_send_u8(void);
@@ -68,9 +287,20 @@ static void ucconfig_send_u16(void);
 static void ucconfig_send_16(void);
 static void ucconfig_send_u32(void);
 static void ucconfig_send_32(void);
+#ifndef UCCONFIG_NO_FLOAT
 static void ucconfig_send_float(void);
+#endif
 static void ucconfig_send_char(void);
 
+//Send a byte as two hexadecimal characters
+static void ucconfig_print_hex(uint8_t byte);
+
+//Check a single data character is valid for the given data type
+static uint8_t ucconfig_valid_char(char character, uint8_t dataType);
+
+//Branch to the write function for the given data type, returns 0 if the type is invalid
+static uint8_t ucconfig_write_type(uint8_t dataType, char *data);
+
 //Write given data types to flash memory when requested by set_data
 static void ucconfig_write_u8(char *data);
 static void ucconfig_write_8(char *data);
@@ -78,18 +308,109 @@ static void ucconfig_write_u16(char *data);
 static void ucconfig_write_16(char *data);
 static void ucconfig_write_u32(char *data);
 static void ucconfig_write_32(char *data);
+#ifndef UCCONFIG_NO_FLOAT
 static void ucconfig_write_float(char *data);
+#endif
 static void ucconfig_write_char(char *data);
 
 void UCCONFIG_loop(void){
 
-    while(ucconfig_activeMode){
+    uint8_t byte;
+
+    //With a clock the timeouts are in ms and nothing needs to block
+    if(ucconfig_fp_clock != NULL){
+
+        UCCONFIG_poll(ucconfig_fp_clock());
+        return;
+    }
+
+    if(atomic_load(&ucconfig_session) == UCCONFIG_SESSION_KEYED){
+
+        ucconfig_active();
+    }
+
+    while(atomic_load(&ucconfig_session) == UCCONFIG_SESSION_ACTIVE){
+
+        //Parse queued bytes one at a time, the timeout only runs down while idle
+        if(FIFO8_spscPop(&ucconfig_fifo,&byte) == E_FIFO8_NOERROR){
+
+            ucconfig_parseByte(byte);
+            continue;
+        }
         
         for(volatile uint16_t i = 0; i < 0xFFF;i++);
-        ucconfig_activeMode--;
+
+        //The PC couldn't talk at the new baud rate, go back to the last one
+        if(ucconfig_baudConfirm && (--ucconfig_baudConfirm == 0)){
+
+            ucconfig_restoreBaud(ucconfig_previousBaud);
+        }
+
+        //Anything received restarts the timeout
+        if(ucconfig_newBytes()){
+
+            ucconfig_idleLoops = UCCONFIG_ACTIVE_MODE_TIMEOUT;
+        }
+        //Timed out, restore outputs and baud rate the same as a terminate
+        else if(--ucconfig_idleLoops == 0){
+
+            ucconfig_exit();
+            ucconfig_restoreBaud(ucconfig_defaultBaud);
+        }
     }
 }
 
+void UCCONFIG_poll(uint32_t now_ms){
+
+    uint8_t byte;
+
+    ucconfig_now = now_ms;
+
+    if(atomic_load(&ucconfig_session) == UCCONFIG_SESSION_KEYED){
+
+        ucconfig_active();
+    }
+
+    if(atomic_load(&ucconfig_session) != UCCONFIG_SESSION_ACTIVE){
+        return;
+    }
+
+    //Anything received since the last poll restarts the timeout
+    if(ucconfig_newBytes()){
+
+        ucconfig_lastReceived = now_ms;
+    }
+
+    //Parse everything queued, a terminate ends the session part way through
+    while((atomic_load(&ucconfig_session) == UCCONFIG_SESSION_ACTIVE) &&
+            (FIFO8_spscPop(&ucconfig_fifo,&byte) == E_FIFO8_NOERROR)){
+
+        ucconfig_parseByte(byte);
+    }
+
+    if(atomic_load(&ucconfig_session) != UCCONFIG_SESSION_ACTIVE){
+        return;
+    }
+
+    //The PC couldn't talk at the new baud rate, go back to the last one
+    if(ucconfig_baudConfirm && (now_ms - ucconfig_baudChanged >= UCCONFIG_BAUD_CONFIRM_MS)){
+
+        ucconfig_restoreBaud(ucconfig_previousBaud);
+    }
+
+    //Timed out, restore outputs and baud rate the same as a terminate
+    if(now_ms - ucconfig_lastReceived >= UCCONFIG_TIMEOUT_MS){
+
+        ucconfig_exit();
+        ucconfig_restoreBaud(ucconfig_defaultBaud);
+    }
+}
+
+void UCCONFIG_setClock(uint32_t (*get_ms)(void)){
+
+    ucconfig_fp_clock = get_ms;
+}
+
 /***********************************************************************/
     //Function relating to the macro expansion of UCCONFIG_get()
 /***********************************************************************/
@@ -106,54 +427,194 @@ void UCCONFIG_setOnFirstWrite(void (*on_first)(void)){
 
     ucconfig_fp_onFirstWrite = on_first;
 }
+void UCCONFIG_setCrc(uint32_t (*crc)(uint16_t address,uint16_t length)){ 
+
+    ucconfig_fp_crc = crc;
+}
+void UCCONFIG_setBaud(uint8_t (*set_baud)(uint32_t baud),uint32_t default_baud){ 
+
+    ucconfig_fp_setBaud = set_baud;
+    ucconfig_defaultBaud = default_baud;
+    ucconfig_baud = default_baud;
+}
+void UCCONFIG_setSerialBlock(void (*serial_block)(const uint8_t *data,uint16_t length)){ 
+
+    ucconfig_fp_serialBlock = serial_block;
+}
 
 void ucconfig_get_c(char *data,uint16_t address){
 
-    ucconfig_memPointer = flash_get(data,address);
-    return;
+    uint8_t bytes[1];
+
+    ucconfig_getBytes(address,bytes,1);
+    *data = (char)bytes[0];
 }
 
 void ucconfig_get_u8(uint8_t *data,uint16_t address){
 
-    ucconfig_memPointer = flash_get(data,address);
-    return;
+    uint8_t bytes[1];
+
+    ucconfig_getBytes(address,bytes,1);
+    *data = bytes[0];
 }
 
 void ucconfig_get_8(int8_t *data,uint16_t address){
 
-    ucconfig_memPointer = flash_get(data,address);
-    return;
+    uint8_t bytes[1];
+
+    ucconfig_getBytes(address,bytes,1);
+    *data = (int8_t)bytes[0];
 }
 
 void ucconfig_get_u16(uint16_t *data,uint16_t address){
 
+    uint8_t bytes[2];
 
-    ucconfig_memPointer = flash_get(data,address);
-    return;
+    ucconfig_getBytes(address,bytes,2);
+    *data = ucconfig_stored16(bytes);
 }
 
 void ucconfig_get_16(int16_t *data,uint16_t address){
 
-    ucconfig_memPointer = flash_get(data,address);
-    return;
+    uint8_t bytes[2];
+
+    ucconfig_getBytes(address,bytes,2);
+    *data = (int16_t)ucconfig_stored16(bytes);
 }
 
 void ucconfig_get_u32(uint32_t *data,uint16_t address){
 
-    ucconfig_memPointer = flash_get(data,address);
-    return;
+    uint8_t bytes[4];
+
+    ucconfig_getBytes(address,bytes,4);
+    *data = ucconfig_stored32(bytes);
 }
 
 void ucconfig_get_32(int32_t *data,uint16_t address){
 
-    ucconfig_memPointer = flash_get(data,address);
-    return;
+    uint8_t bytes[4];
+
+    ucconfig_getBytes(address,bytes,4);
+    *data = (int32_t)ucconfig_stored32(bytes);
 }
 
+#ifndef UCCONFIG_NO_FLOAT
 void ucconfig_get_float(float *data,uint16_t address){
 
-    ucconfig_memPointer = flash_get(data,address);
-    return;
+    uint8_t bytes[4];
+
+    ucconfig_getBytes(address,bytes,4);
+    //Same conversion as FLASHWRITE_read_float()
+    *data = FLASHWRITE_to_float(ucconfig_stored32(bytes));
+}
+
+void ucconfig_get_double(double *data,uint16_t address){
+
+    uint8_t bytes[8];
+
+    ucconfig_getBytes(address,bytes,8);
+    *data = ucconfig_storedDouble(bytes);
+}
+#endif
+
+void UCCONFIG_setShadow(uint8_t *buffer,uint16_t address,uint16_t size){
+
+    ucconfig_shadowSize = 0;
+
+    if(buffer == NULL){
+        return;
+    }
+
+    //One read for the whole region, after this the shadow follows every write
+    ucconfig_flashReadBlock(address,buffer,size);
+
+    ucconfig_shadow = buffer;
+    ucconfig_shadowAddress = address;
+    ucconfig_shadowSize = size;
+}
+
+void UCCONFIG_read(uint16_t address,uint8_t *data,uint16_t length){
+
+#ifdef UCCONFIG_MEMORY_MAPPED
+    memcpy(data,(const void*)((uintptr_t)(UCCONFIG_MEMORY_BASE) + address),length);
+#else
+    ucconfig_getBytes(address,data,length);
+#endif
+}
+
+void ucconfig_decode_8(void *data){
+
+    (void)data;
+}
+
+void ucconfig_decode_16(void *data){
+
+    uint16_t value = ucconfig_stored16(data);
+
+    memcpy(data,&value,2);
+}
+
+void ucconfig_decode_32(void *data){
+
+    uint32_t value = ucconfig_stored32(data);
+
+    memcpy(data,&value,4);
+}
+
+#ifndef UCCONFIG_NO_FLOAT
+void ucconfig_decode_float(void *data){
+
+    //Same conversion as FLASHWRITE_read_float()
+    float value = FLASHWRITE_to_float(ucconfig_stored32(data));
+
+    memcpy(data,&value,4);
+}
+
+void ucconfig_decode_double(void *data){
+
+    double value = ucconfig_storedDouble(data);
+
+    memcpy(data,&value,8);
+}
+#endif
+
+static const uint8_t *ucconfig_shadowBytes(uint16_t address,uint16_t length){
+
+    uint16_t offset = address - ucconfig_shadowAddress;
+
+    //Unsigned compare, addresses below the shadow wrap around to large offsets
+    if((offset >= ucconfig_shadowSize) || (ucconfig_shadowSize - offset < length)){
+        return NULL;
+    }
+
+    return &ucconfig_shadow[offset];
+}
+
+static void ucconfig_getBytes(uint16_t address,uint8_t *data,uint16_t length){
+
+    const uint8_t *shadow = ucconfig_shadowBytes(address,length);
+
+    if(shadow != NULL){
+
+        memcpy(data,shadow,length);
+        return;
+    }
+
+    //During a session the FLASHWRITE input set by ucconfig_active() also sees staged bytes
+    if(atomic_load(&ucconfig_session) == UCCONFIG_SESSION_ACTIVE){
+
+        FLASHWRITE_read_block(data,length,address);
+        return;
+    }
+
+    ucconfig_flashReadBlock(address,data,length);
+}
+
+static void ucconfig_shadowLoad(void){
+
+    if(ucconfig_shadowSize > 0){
+        ucconfig_flashReadBlock(ucconfig_shadowAddress,ucconfig_shadow,ucconfig_shadowSize);
+    }
 }
 
 void UCCONFIG_setAddressOffset(uint16_t address){
@@ -161,29 +622,49 @@ void UCCONFIG_setAddressOffset(uint16_t address){
     ucconfig_memPointerOffset = address;
 }
 
-//Main config loop, gets triggered by ucconfig_checkKey when a valid key is found
+//Start config mode, called by UCCONFIG_loop() or UCCONFIG_poll() once UCCONFIG_listen() has found the key
 void ucconfig_active(void){
 
-    //Store the current function pointer for STRING11 output
-    void (*current_fp)(uint8_t) = STRING11_getOutput();
-
-    //Store current flashwrite fp
-    void (*current_fw_fp)(uint8_t,uint16_t) = FLASHWRITE_getOutput();
-    uint8_t (*current_fr_fp)(uint16_t) = FLASHWRITE_getInput();
+    //Store the current function pointers for STRING11 and flashWrite, restored on exit
+    ucconfig_saved_print = STRING11_getOutput();
+    ucconfig_saved_flashWrite = FLASHWRITE_getOutput();
+    ucconfig_saved_flashRead = FLASHWRITE_getInput();
+    ucconfig_saved_blockWrite = FLASHWRITE_getBlockOutput();
+    ucconfig_saved_blockRead = FLASHWRITE_getBlockInput();
+    ucconfig_saved_printBlock = STRING11_getBlockOutput();
+    ucconfig_saved_printBuffer = STRING11_getBuffer(&ucconfig_saved_printBufferSize);
 
     //Set the output function for STRING_11 to serial fp, this allows use of all print functions
+    //With a block function frames are buffered, anything the application buffered is sent first
     STRING11_setOutput(ucconfig_fp_serialWrite);
+    STRING11_setBlockOutput(ucconfig_fp_serialBlock);
+    STRING11_setBuffer(ucconfig_txBuffer,UCCONFIG_TX_BUFFER_SIZE);
 
-    //Setup flash output
-    FLASHWRITE_setOutput(ucconfig_fp_flashWrite);
-    FLASHWRITE_setInput(ucconfig_fp_flashRead);
+    //Setup flash output, through the staging buffer if there is one
+    //Staged bytes are in RAM so byte calls are cheap, pages go to flash as blocks
+    if(ucconfig_stageCount > 0){
+
+        FLASHWRITE_setOutput(ucconfig_stageWrite);
+        FLASHWRITE_setInput(ucconfig_stageRead);
+        FLASHWRITE_setBlockOutput(NULL);
+        FLASHWRITE_setBlockInput(NULL);
+    }
+    else{
 
-    //Store the old FP in config fp for later resetting
-    ucconfig_fp_serialWrite = current_fp;
-    ucconfig_fp_flashWrite = current_fw_fp;
-    ucconfig_fp_flashRead = current_fr_fp;
+        //Accesses always go through ucconfig_flashWriteBlock() and ucconfig_flashReadBlock() so
+        //the shadow follows writes and both are mapped to a bank
+        FLASHWRITE_setOutput(ucconfig_fp_flashWrite);
+        FLASHWRITE_setInput(ucconfig_fp_flashRead);
+        FLASHWRITE_setBlockOutput(ucconfig_flashWriteBlock);
+        FLASHWRITE_setBlockInput(ucconfig_flashReadBlock);
+    }
 
     ucconfig_written = 0;
+    ucconfig_programmed = 0;
+    ucconfig_refusedBaud = 0;
+
+    //The key has no sequence, parsing starts from a fresh frame as ucconfig_exit() left it
+    ucconfig_sequence = UCCONFIG_NULL;
 
     ucconfig_sendAck();
 
@@ -192,7 +673,12 @@ void ucconfig_active(void){
         ucconfig_fp_onEnter();
     }
 
-    ucconfig_activeMode = UCCONFIG_ACTIVE_MODE_TIMEOUT;
+    //The timeout starts now, bytes queued since the key are parsed by the caller
+    ucconfig_newBytes();
+    ucconfig_idleLoops = UCCONFIG_ACTIVE_MODE_TIMEOUT;
+    ucconfig_lastReceived = ucconfig_now;
+
+    atomic_store(&ucconfig_session,UCCONFIG_SESSION_ACTIVE);
     return;
 }
 
@@ -200,91 +686,166 @@ void ucconfig_active(void){
 //If frame is valid writes the given data to flash
 void ucconfig_write_data(){
 
-    uint8_t dataLength;
-    uint8_t dataType;
-    char data[24]; //maximum size in characters of data i 24 bytes
     uint8_t i;
 
-    //Data type is checked later when branching to flash write functions
-    dataType = FIFO8_pop(&ucconfig_fifo);
+    //Check length, max length is 24
+    if((ucconfig_frame.length < 1) | (ucconfig_frame.length > 24)){
+
+        ucconfig_sendNack();
+        return;
+    }
 
-    //Length is the capital letter of the aplphabet. eg. A = 1, C = 3
-    dataLength = FIFO8_pop(&ucconfig_fifo) - 64 ;
+    for(i = 0; i < ucconfig_frame.length; i++){
 
-    //Check length, max length is 24
-    if((dataLength < 1) | (dataLength > 24)){
+        if(!ucconfig_valid_char(ucconfig_frame.data[i],ucconfig_frame.type)){
+            //Not a valid data value
+            ucconfig_sendNack();
+            return;
+        }
+    }
+
+    //Branch and write data if the type was valid
+    if(!ucconfig_write_type(ucconfig_frame.type,ucconfig_frame.data)){
 
         ucconfig_sendNack();
         return;
     }
 
-    //Next two should be not used charaters
-    if(FIFO8_pop(&ucconfig_fifo) != UCCONFIG_NOT_USED){
+    ucconfig_written++;
+
+    //All good, let PC know write is finished.
+    ucconfig_sendAck();
+
+}
+
+//Called when a successful bulk write command was initiated.
+//The payload is a run of values, each led by its type character. The whole
+//payload is validated before anything is written so the frame is all or nothing.
+void ucconfig_bulk_write_data(){
+
+    uint8_t dataLength = ucconfig_frame.length;
+    uint8_t dataType;
+    char *data = ucconfig_frame.data;
+    char next;
+    uint8_t i;
+    uint8_t start;
+
+    //Frame pos 3 is type, should be none as each value carries its own type
+    if(ucconfig_frame.type != UCCONFIG_TYPE_NONE){
         ucconfig_sendNack();
         return;
     }
 
-    if(FIFO8_pop(&ucconfig_fifo) != UCCONFIG_NOT_USED){
+    //Smallest payload is a single type character and one data character
+    if(dataLength < 2){
+
         ucconfig_sendNack();
         return;
     }
 
-    for(i = 0; i < dataLength; i++){
+    //Check every value, type characters are all below printable ASCII
+    i = 0;
+    while(i < dataLength){
 
-        data[i] = FIFO8_pop(&ucconfig_fifo);
+        dataType = data[i++];
+        start = i;
 
-        //Check the data is only numbers
-        if((data[i] > 47) && (data[i] < 58)){
-            
-        }
-        //If there is a period, make sure the type is float
-        else if((data[i] == 46) && (dataType == UCCONFIG_TYPE_FLOAT)){
+        while((i < dataLength) && (data[i] >= ' ')){
 
+            if(!ucconfig_valid_char(data[i],dataType)){
+                ucconfig_sendNack();
+                return;
+            }
+            i++;
         }
-        //Check for minus for 8 bit
-        else if(data[i] == 45 && (dataType == UCCONFIG_TYPE_INT8_T)){
 
+        //Every type needs a value, and a char value is a single character
+        if((i == start) || ((dataType == UCCONFIG_TYPE_CHAR) && (i - start != 1))){
+            ucconfig_sendNack();
+            return;
         }
-        //Check for minus for 16 bit
-        else if(data[i] == 45 && (dataType == UCCONFIG_TYPE_INT16_T)){
 
+        if((dataType < UCCONFIG_TYPE_UINT8_T) || (dataType > UCCONFIG_TYPE_CHAR)){
+            ucconfig_sendNack();
+            return;
         }
-        //Check for minus for 32 bit
-        else if(data[i] == 45 && (dataType == UCCONFIG_TYPE_INT32_T)){
-
+#ifdef UCCONFIG_NO_FLOAT
+        //Not written, the values after it would be stored at the wrong address
+        if(dataType == UCCONFIG_TYPE_FLOAT){
+            ucconfig_sendNack();
+            return;
         }
-        //Check for minus for float
-        else if(data[i] == 45 && (dataType == UCCONFIG_TYPE_FLOAT)){
+#endif
+    }
 
-        }
-        //Char can be anything
-        else if(dataType == UCCONFIG_TYPE_CHAR){
+    //Everything is valid, write each value in turn
+    i = 0;
+    while(i < dataLength){
 
+        dataType = data[i++];
+        start = i;
+
+        while((i < dataLength) && (data[i] >= ' ')){
+            i++;
         }
-        else{
-            //Not a valid data value
+
+        //Terminate the value in place, restoring the next type character after
+        next = data[i];
+        data[i] = 0;
+
+        //Every type was checked above, so this only fails if the two disagree
+        if(!ucconfig_write_type(dataType,&data[start])){
+
             ucconfig_sendNack();
             return;
         }
-    }
+        data[i] = next;
 
-    //Null should follow data
-    if(FIFO8_pop(&ucconfig_fifo) != UCCONFIG_NULL){
-        ucconfig_sendNack();
-        return;
+        ucconfig_written++;
     }
 
-    //Make sure data is correct length
-    if(i != dataLength){
+    //All good, one acknowledge for the whole run
+    ucconfig_sendAck();
+}
+
+//Returns 1 if the character is valid for the given data type
+static uint8_t ucconfig_valid_char(char character, uint8_t dataType){
 
-        ucconfig_sendNack();
-        return;
+    //Check the data is only numbers
+    if((character > 47) && (character < 58)){
+        return 1;
+    }
+    //If there is a period, make sure the type is float
+    else if((character == 46) && (dataType == UCCONFIG_TYPE_FLOAT)){
+        return 1;
+    }
+    //Check for minus for 8 bit
+    else if(character == 45 && (dataType == UCCONFIG_TYPE_INT8_T)){
+        return 1;
+    }
+    //Check for minus for 16 bit
+    else if(character == 45 && (dataType == UCCONFIG_TYPE_INT16_T)){
+        return 1;
+    }
+    //Check for minus for 32 bit
+    else if(character == 45 && (dataType == UCCONFIG_TYPE_INT32_T)){
+        return 1;
+    }
+    //Check for minus for float
+    else if(character == 45 && (dataType == UCCONFIG_TYPE_FLOAT)){
+        return 1;
+    }
+    //Char can be anything
+    else if(dataType == UCCONFIG_TYPE_CHAR){
+        return 1;
     }
 
-    //Add a null character
-    data[i] = 0;
+    return 0;
+}
+
+//Branch and write data if the type was valid
+static uint8_t ucconfig_write_type(uint8_t dataType, char *data){
 
-    //Branch and write data if the type was valid
     switch(dataType){
 
         case UCCONFIG_TYPE_UINT8_T: 
@@ -311,30 +872,34 @@ void ucconfig_write_data(){
             ucconfig_call_if_first();
             ucconfig_write_32(data);
             break;
+#ifndef UCCONFIG_NO_FLOAT
         case UCCONFIG_TYPE_FLOAT: 
             ucconfig_call_if_first();
             ucconfig_write_float(data);
             break;
+#endif
         case UCCONFIG_TYPE_CHAR: 
             ucconfig_call_if_first();
             ucconfig_write_char(data);
             break;
         default:
-            ucconfig_sendNack();
-            return;
-
+            return 0;
     }
 
-    ucconfig_written++;
-
-    //All good, let PC know write is finished.
-    ucconfig_sendAck();
-
+    return 1;
 }
 static void ucconfig_call_if_first(void){
 
+    //The bank copy waits for the first byte which changes, see ucconfig_flashWriteBlock()
     if(ucconfig_written == 0){
-        ucconfig_fp_onFirstWrite();
+
+        if(ucconfig_fp_onFirstWrite != NULL){
+
+            ucconfig_fp_onFirstWrite();
+
+            //It may have erased flash, writes are compared with the shadow
+            ucconfig_shadowLoad();
+        }
     }
 
     return;
@@ -386,12 +951,14 @@ static void ucconfig_write_32(char *data){
     ucconfig_memPointer = flash_put(toWrite,ucconfig_memPointer);
 }
 
+#ifndef UCCONFIG_NO_FLOAT
 static void ucconfig_write_float(char *data){
 
     float toWrite;
     toWrite = str2float(data);
     ucconfig_memPointer = flash_put(toWrite,ucconfig_memPointer);
 }
+#endif
 
 static void ucconfig_write_char(char *data){
 
@@ -403,33 +970,14 @@ static void ucconfig_write_char(char *data){
 //Responds with Nack frame is invalid
 void ucconfig_read_data(){
 
-    uint8_t dataType = FIFO8_pop(&ucconfig_fifo);
-
     //Length should be zero for get data
-    if((FIFO8_pop(&ucconfig_fifo) != UCCONFIG_LENGTH_ZERO)){
-
-        ucconfig_sendNack();
-        return;
-    }
-
-    //Next two should be not used charaters
-    if(FIFO8_pop(&ucconfig_fifo) != UCCONFIG_NOT_USED){
-        ucconfig_sendNack();
-        return;
-    }
-
-    if(FIFO8_pop(&ucconfig_fifo) != UCCONFIG_NOT_USED){
-        ucconfig_sendNack();
-        return;
-    }
+    if(ucconfig_frame.length != 0){
 
-    //Last is Null character
-    if(FIFO8_pop(&ucconfig_fifo) != UCCONFIG_NULL){
         ucconfig_sendNack();
         return;
     }
 
-    switch(dataType){
+    switch(ucconfig_frame.type){
 
         case UCCONFIG_TYPE_UINT8_T:
             ucconfig_send_u8();
@@ -449,9 +997,11 @@ void ucconfig_read_data(){
         case UCCONFIG_TYPE_INT32_T:
             ucconfig_send_32();
             break;
+#ifndef UCCONFIG_NO_FLOAT
         case UCCONFIG_TYPE_FLOAT:
             ucconfig_send_float();
             break;
+#endif
         case UCCONFIG_TYPE_CHAR:
             ucconfig_send_char();
             break;
@@ -472,7 +1022,7 @@ void ucconfig_send_u8(void){
     ucconfig_memPointer = flash_get(&data,ucconfig_memPointer);
 
     print((char)UCCONFIG_READ_FRAME);
-    print((char)UCCONFIG_NULL);
+    print((char)ucconfig_sequence);
     print((char)UCCONFIG_TYPE_UINT8_T);
     print((char)UCCONFIG_LENGTH_ZERO);
     print((char)UCCONFIG_NOT_USED);
@@ -480,7 +1030,7 @@ void ucconfig_send_u8(void){
     print(data);
     print((char)UCCONFIG_NULL);
     print((char)UCCONFIG_FRAME_END);
-    print((char)UCCONFIG_NEWLINE);
+    ucconfig_endFrame();
     return;
 }
 
@@ -491,7 +1041,7 @@ void ucconfig_send_8(void){
     ucconfig_memPointer = flash_get(&data,ucconfig_memPointer);
 
     print((char)UCCONFIG_READ_FRAME);
-    print((char)UCCONFIG_NULL);
+    print((char)ucconfig_sequence);
     print((char)UCCONFIG_TYPE_INT8_T);
     print((char)UCCONFIG_LENGTH_ZERO);
     print((char)UCCONFIG_NOT_USED);
@@ -499,7 +1049,7 @@ void ucconfig_send_8(void){
     print((int8_t)data);
     print((char)UCCONFIG_NULL);
     print((char)UCCONFIG_FRAME_END);
-    print((char)UCCONFIG_NEWLINE);
+    ucconfig_endFrame();
     return;
 }
 
@@ -510,7 +1060,7 @@ void ucconfig_send_u16(void){
     ucconfig_memPointer = flash_get(&data,ucconfig_memPointer);
 
     print((char)UCCONFIG_READ_FRAME);
-    print((char)UCCONFIG_NULL);
+    print((char)ucconfig_sequence);
     print((char)UCCONFIG_TYPE_UINT16_T);
     print((char)UCCONFIG_LENGTH_ZERO);
     print((char)UCCONFIG_NOT_USED);
@@ -518,7 +1068,7 @@ void ucconfig_send_u16(void){
     print(data);
     print((char)UCCONFIG_NULL);
     print((char)UCCONFIG_FRAME_END);
-    print((char)UCCONFIG_NEWLINE);
+    ucconfig_endFrame();
     return;
 }
 
@@ -529,7 +1079,7 @@ void ucconfig_send_16(void){
     ucconfig_memPointer = flash_get(&data,ucconfig_memPointer);
 
     print((char)UCCONFIG_READ_FRAME);
-    print((char)UCCONFIG_NULL);
+    print((char)ucconfig_sequence);
     print((char)UCCONFIG_TYPE_INT16_T);
     print((char)UCCONFIG_LENGTH_ZERO);
     print((char)UCCONFIG_NOT_USED);
@@ -537,7 +1087,7 @@ void ucconfig_send_16(void){
     print(data);
     print((char)UCCONFIG_NULL);
     print((char)UCCONFIG_FRAME_END);
-    print((char)UCCONFIG_NEWLINE);
+    ucconfig_endFrame();
     return;
 }
 
@@ -548,7 +1098,7 @@ void ucconfig_send_u32(void){
     ucconfig_memPointer = flash_get(&data,ucconfig_memPointer);
 
     print((char)UCCONFIG_READ_FRAME);
-    print((char)UCCONFIG_NULL);
+    print((char)ucconfig_sequence);
     print((char)UCCONFIG_TYPE_UINT32_T);
     print((char)UCCONFIG_LENGTH_ZERO);
     print((char)UCCONFIG_NOT_USED);
@@ -556,7 +1106,7 @@ void ucconfig_send_u32(void){
     print(data);
     print((char)UCCONFIG_NULL);
     print((char)UCCONFIG_FRAME_END);
-    print((char)UCCONFIG_NEWLINE);
+    ucconfig_endFrame();
     return;
 }
 
@@ -567,7 +1117,7 @@ void ucconfig_send_32(void){
     ucconfig_memPointer = flash_get(&data,ucconfig_memPointer);
 
     print((char)UCCONFIG_READ_FRAME);
-    print((char)UCCONFIG_NULL);
+    print((char)ucconfig_sequence);
     print((char)UCCONFIG_TYPE_INT32_T);
     print((char)UCCONFIG_LENGTH_ZERO);
     print((char)UCCONFIG_NOT_USED);
@@ -575,10 +1125,11 @@ void ucconfig_send_32(void){
     print(data);
     print((char)UCCONFIG_NULL);
     print((char)UCCONFIG_FRAME_END);
-    print((char)UCCONFIG_NEWLINE);
+    ucconfig_endFrame();
     return;
 }
 
+#ifndef UCCONFIG_NO_FLOAT
 void ucconfig_send_float(void){
 
     //get data
@@ -586,7 +1137,7 @@ void ucconfig_send_float(void){
     ucconfig_memPointer = flash_get(&data,ucconfig_memPointer);
 
     print((char)UCCONFIG_READ_FRAME);
-    print((char)UCCONFIG_NULL);
+    print((char)ucconfig_sequence);
     print((char)UCCONFIG_TYPE_FLOAT);
     print((char)UCCONFIG_LENGTH_ZERO);
     print((char)UCCONFIG_NOT_USED);
@@ -594,9 +1145,10 @@ void ucconfig_send_float(void){
     print(data);
     print((char)UCCONFIG_NULL);
     print((char)UCCONFIG_FRAME_END);
-    print((char)UCCONFIG_NEWLINE);
+    ucconfig_endFrame();
     return;
 }
+#endif
 
 void ucconfig_send_char(void){
 
@@ -605,7 +1157,7 @@ void ucconfig_send_char(void){
     ucconfig_memPointer = flash_get(&data,ucconfig_memPointer);
 
     print((char)UCCONFIG_READ_FRAME);
-    print((char)UCCONFIG_NULL);
+    print((char)ucconfig_sequence);
     print((char)UCCONFIG_TYPE_CHAR);
     print((char)UCCONFIG_LENGTH_ZERO);
     print((char)UCCONFIG_NOT_USED);
@@ -613,76 +1165,192 @@ void ucconfig_send_char(void){
     print(data);
     print((char)UCCONFIG_NULL);
     print((char)UCCONFIG_FRAME_END);
-    print((char)UCCONFIG_NEWLINE);
+    ucconfig_endFrame();
     return;
 }
 
-//Sets the current memeory address of the flash pointer + offset
-//Responds with ack if ok or nack if error in received frame.
-void ucconfig_set_address(){
+//Called when a successful read block command was sent
+//Sends the requested number of raw bytes from the current address in one frame
+//Responds with Nack if frame is invalid
+void ucconfig_read_block(){
 
-    uint8_t addressLength;
-    char address[6]; //maximum size in characters of 16 bit number is 5. +1 for NULL terminator
-    uint8_t i;
+    uint16_t bytes;
+    uint16_t chunk;
+    uint16_t i;
+    uint8_t data[16];
+
+    bytes = ucconfig_read_count();
 
-    //Frame pos 3 is type, should be none for address
-    if(FIFO8_pop(&ucconfig_fifo) != UCCONFIG_TYPE_NONE){
+    if(bytes == 0){
         ucconfig_sendNack();
         return;
     }
 
-    //Length is the capital letter of the aplphabet. eg. A = 1, C = 3
-    addressLength = FIFO8_pop(&ucconfig_fifo) - 64 ;
+    print((char)UCCONFIG_READ_BLOCK_FRAME);
+    print((char)ucconfig_sequence);
+    print((char)UCCONFIG_TYPE_NONE);
+    print((char)UCCONFIG_LENGTH_ZERO);
+    print((char)UCCONFIG_NOT_USED);
+    print((char)UCCONFIG_NOT_USED);
 
-    //Check length, a 16 bit number won't be longer than 5 digits
-    if((addressLength < 1) | (addressLength > 5)){
+    //Stream from flash a few bytes at a time, one block read each
+    while(bytes > 0){
 
-        ucconfig_sendNack();
-        return;
+        chunk = (bytes > sizeof(data)) ? sizeof(data) : bytes;
+        ucconfig_memPointer = FLASHWRITE_read_block(data,chunk,ucconfig_memPointer);
+
+        for(i = 0; i < chunk; i++){
+            ucconfig_print_hex(data[i]);
+        }
+
+        bytes -= chunk;
     }
 
-    //Next two should be not used charaters
-    if(FIFO8_pop(&ucconfig_fifo) != UCCONFIG_NOT_USED){
+    print((char)UCCONFIG_NULL);
+    print((char)UCCONFIG_FRAME_END);
+    ucconfig_endFrame();
+}
+
+//Called when a successful CRC command was sent
+//Sends the CRC of the requested number of bytes from the current address
+//The memory address isn't moved so the region can be read back if the CRC is wrong
+void ucconfig_crc_block(){
+
+    uint16_t bytes;
+    uint32_t crc;
+
+    bytes = ucconfig_read_count();
+
+    if(bytes == 0){
         ucconfig_sendNack();
         return;
     }
 
-    if(FIFO8_pop(&ucconfig_fifo) != UCCONFIG_NOT_USED){
-        ucconfig_sendNack();
-        return;
+    //Only the default CRC reads through the staging buffer
+    if(ucconfig_fp_crc != ucconfig_crc32){
+        ucconfig_stageCommit();
+    }
+
+    //A CRC function other than the default reads flash itself, so it's given the bank address
+    if(ucconfig_fp_crc == ucconfig_crc32){
+        crc = ucconfig_crc32(ucconfig_memPointer,bytes);
     }
+    else{
+        crc = ucconfig_fp_crc(ucconfig_bankAddress(ucconfig_memPointer),bytes);
+    }
+
+    print((char)UCCONFIG_CRC_FRAME);
+    print((char)ucconfig_sequence);
+    print((char)UCCONFIG_TYPE_UINT32_T);
+    print((char)UCCONFIG_LENGTH_ZERO);
+    print((char)UCCONFIG_NOT_USED);
+    print((char)UCCONFIG_NOT_USED);
+    print(crc);
+    print((char)UCCONFIG_NULL);
+    print((char)UCCONFIG_FRAME_END);
+    ucconfig_endFrame();
+}
 
+//The frame data is the number of bytes as decimal characters
+static uint16_t ucconfig_read_count(void){
 
-    //Address should only contain numbers
-    for(i = 0; i < addressLength; i++){
+    uint32_t bytes;
 
-        address[i] = FIFO8_pop(&ucconfig_fifo);
+    //A 16 bit number won't be longer than 5 digits
+    if(!ucconfig_digits(5)){
+        return 0;
+    }
 
-        if((address[i] < 48) | (address[i] > 57)){
-            
-            ucconfig_sendNack();
-            return;
+    bytes = str2uint(ucconfig_frame.data);
+
+    //More than the 16 bit address space is invalid
+    if(bytes > 0xFFFF){
+        return 0;
+    }
+
+    return (uint16_t)bytes;
+}
+
+static uint8_t ucconfig_digits(uint8_t maxLength){
+
+    uint8_t i;
+
+    //Frame pos 3 is type, should be none for a number
+    if(ucconfig_frame.type != UCCONFIG_TYPE_NONE){
+        return 0;
+    }
+
+    if((ucconfig_frame.length < 1) | (ucconfig_frame.length > maxLength)){
+        return 0;
+    }
+
+    //Should only contain numbers
+    for(i = 0; i < ucconfig_frame.length; i++){
+
+        if((ucconfig_frame.data[i] < 48) | (ucconfig_frame.data[i] > 57)){
+            return 0;
         }
     }
 
-    //Make sure the lenght of the address maches the acual data
-    if(i != addressLength){
+    return 1;
+}
 
-        ucconfig_sendNack();
-        return;
+//Bitwise CRC-32 (reflected polynomial 0xEDB88320), slow but needs no table
+static uint32_t ucconfig_crc32(uint16_t address,uint16_t length){
+
+    uint32_t crc = 0xFFFFFFFF;
+    uint8_t data[16];
+    uint16_t chunk;
+
+    while(length > 0){
+
+        chunk = (length > sizeof(data)) ? sizeof(data) : length;
+        address = FLASHWRITE_read_block(data,chunk,address);
+        length -= chunk;
+        crc = ucconfig_crcUpdate(crc,data,chunk);
+    }
+
+    return ~crc;
+}
+
+static uint32_t ucconfig_crcUpdate(uint32_t crc,const uint8_t *data,uint16_t length){
+
+    uint16_t i;
+    uint8_t bit;
+
+    for(i = 0; i < length; i++){
+
+        crc ^= data[i];
+
+        for(bit = 0; bit < 8; bit++){
 
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
     }
 
-    //Null character last
-    if(FIFO8_pop(&ucconfig_fifo) != UCCONFIG_NULL){
+    return crc;
+}
+
+static void ucconfig_print_hex(uint8_t byte){
+
+    static const char hex[] = "0123456789ABCDEF";
+
+    print((char)hex[byte >> 4]);
+    print((char)hex[byte & 0x0F]);
+}
+
+//Sets the current memeory address of the flash pointer + offset
+//Responds with ack if ok or nack if error in received frame.
+void ucconfig_set_address(){
+
+    //A 16 bit number won't be longer than 5 digits
+    if(!ucconfig_digits(5)){
         ucconfig_sendNack();
         return;
     }
 
-    address[i] = 0;
-
     //Set the memeory pointer address plus the offset.
-    ucconfig_memPointer = (uint16_t)str2int(address) + ucconfig_memPointerOffset;
+    ucconfig_memPointer = (uint16_t)str2int(ucconfig_frame.data) + ucconfig_memPointerOffset;
 
     //All good
     ucconfig_sendAck();
@@ -693,38 +1361,21 @@ void ucconfig_set_address(){
 void ucconfig_get_address(){
     
     //Frame pos 3 is type, should be none for getAddress
-    if(FIFO8_pop(&ucconfig_fifo) != UCCONFIG_TYPE_NONE){
+    if(ucconfig_frame.type != UCCONFIG_TYPE_NONE){
         ucconfig_sendNack();
         return;
     }
 
     //Length should be zero for get address
-    if((FIFO8_pop(&ucconfig_fifo) != UCCONFIG_LENGTH_ZERO)){
-
-        ucconfig_sendNack();
-        return;
-    }
-
-    //Next two should be not used charaters
-    if(FIFO8_pop(&ucconfig_fifo) != UCCONFIG_NOT_USED){
-        ucconfig_sendNack();
-        return;
-    }
-
-    if(FIFO8_pop(&ucconfig_fifo) != UCCONFIG_NOT_USED){
-        ucconfig_sendNack();
-        return;
-    }
+    if(ucconfig_frame.length != 0){
 
-    //Last is Null character
-    if(FIFO8_pop(&ucconfig_fifo) != UCCONFIG_NULL){
         ucconfig_sendNack();
         return;
     }
 
     //Send that puppy
     print((char)UCCONFIG_AT_ADDRESS);
-    print((char)UCCONFIG_NULL);
+    print((char)ucconfig_sequence);
     print((char)UCCONFIG_TYPE_NONE);
     print((char)UCCONFIG_LENGTH_ZERO);
     print((char)UCCONFIG_NOT_USED);
@@ -732,327 +1383,1125 @@ void ucconfig_get_address(){
     print(ucconfig_memPointer);
     print((char)UCCONFIG_NULL);
     print((char)UCCONFIG_FRAME_END);
-    print((char)UCCONFIG_NEWLINE);
+    ucconfig_endFrame();
 }
 
 //Exit from config mode if the terminate frame was valid.
 void ucconfig_terminate(){
 
     //Frame pos 3 is type, should be none for terminate
-    if(FIFO8_pop(&ucconfig_fifo) != UCCONFIG_TYPE_NONE){
+    if(ucconfig_frame.type != UCCONFIG_TYPE_NONE){
         ucconfig_sendNack();
         return;
     }
 
     //Length should be zero for terminate
-    if((FIFO8_pop(&ucconfig_fifo) != UCCONFIG_LENGTH_ZERO)){
+    if(ucconfig_frame.length != 0){
 
         ucconfig_sendNack();
         return;
     }
 
-    //Next two should be not used charaters
-    if(FIFO8_pop(&ucconfig_fifo) != UCCONFIG_NOT_USED){
+    //The config written this session is used from now on
+    ucconfig_bankCommit();
+
+    //Leave config mode before acknowledging, the PC can send the key again as soon
+    //as it sees the acknowledge and the key must find module outputs restored
+    ucconfig_exit();
+
+    //STRING11 belongs to the application again, so write the acknowledge directly
+    uint8_t ack[4] = {UCCONFIG_ACK,ucconfig_sequence,UCCONFIG_FRAME_END,UCCONFIG_NEWLINE};
+
+    if(ucconfig_fp_serialBlock != NULL){
+
+        ucconfig_fp_serialBlock(ack,4);
+    }
+    else{
+
+        for(uint8_t i = 0; i < 4; i++){
+
+            ucconfig_fp_serialWrite(ack[i]);
+        }
+    }
+
+    //The acknowledge goes at the session rate, the PC switches back once it has it
+    ucconfig_restoreBaud(ucconfig_defaultBaud);
+
+    if(ucconfig_fp_onExit != NULL){
+
+        ucconfig_fp_onExit();
+    }
+}
+
+//Sets the baud rate requested by the PC
+//A request for the rate already in use confirms it, otherwise the acknowledge is
+//sent at the current rate and the PC has to confirm the new one.
+void ucconfig_set_baud(){
+
+    uint32_t baud;
+
+    //Baud rates won't be longer than 7 digits
+    if(!ucconfig_digits(7)){
         ucconfig_sendNack();
         return;
     }
 
-    if(FIFO8_pop(&ucconfig_fifo) != UCCONFIG_NOT_USED){
+    baud = str2uint(ucconfig_frame.data);
+
+    if((ucconfig_fp_setBaud == NULL) || (baud == 0)){
         ucconfig_sendNack();
         return;
     }
 
-    //Last is Null character
-    if(FIFO8_pop(&ucconfig_fifo) != UCCONFIG_NULL){
+    //Received at the rate in use, so the PC can talk at it
+    if(baud == ucconfig_baud){
+
+        ucconfig_baudConfirm = 0;
+        ucconfig_sendAck();
+        return;
+    }
+
+    //Only change from a confirmed rate, and don't try an unsupported rate again
+    if((ucconfig_baudConfirm) || (baud == ucconfig_refusedBaud)){
         ucconfig_sendNack();
         return;
     }
 
-    //Everythin good send the acknowledge
     ucconfig_sendAck();
 
-    //Store the current function pointer for STRING11 output
-    void (*current_fp)(uint8_t) = STRING11_getOutput();
+    if(ucconfig_fp_setBaud(baud)){
 
-    //Store current flashwrite fp
-    void (*current_fw_fp)(uint8_t,uint16_t) = FLASHWRITE_getOutput();
-    uint8_t (*current_fr_fp)(uint16_t) = FLASHWRITE_getInput();
+        ucconfig_previousBaud = ucconfig_baud;
+        ucconfig_baud = baud;
+        ucconfig_baudConfirm = UCCONFIG_BAUD_CONFIRM_TIMEOUT;
+        ucconfig_baudChanged = ucconfig_now;
+    }
+    else{
 
-    //Set the output function for STRING_11 to serial fp, this allows use of all print functions
-    STRING11_setOutput(ucconfig_fp_serialWrite);
+        ucconfig_refusedBaud = baud;
+    }
+}
 
-    //Setup flash output
-    FLASHWRITE_setOutput(ucconfig_fp_flashWrite);
-    FLASHWRITE_setInput(ucconfig_fp_flashRead);
+static void ucconfig_restoreBaud(uint32_t baud){
 
-    //Store the old FP in config fp for later resetting
-    ucconfig_fp_serialWrite = current_fp;
-    ucconfig_fp_flashWrite = current_fw_fp;
-    ucconfig_fp_flashRead = current_fr_fp;
+    ucconfig_baudConfirm = 0;
 
-    if(ucconfig_fp_onExit != NULL){
+    if(baud == ucconfig_baud){
+        return;
+    }
 
-        ucconfig_fp_onExit();
+    ucconfig_fp_setBaud(baud);
+    ucconfig_baud = baud;
+}
+
+static uint8_t ucconfig_newBytes(void){
+
+    uint8_t received = (uint8_t)atomic_load(&ucconfig_received);
+
+    if(received == ucconfig_receivedSeen){
+        return 0;
     }
 
-    //Set the flag so active mode loop terminates
-    ucconfig_activeMode = 0;
+    ucconfig_receivedSeen = received;
+    return 1;
+}
+
+//Restore the outputs stored by ucconfig_active() and leave config mode, called by the consumer
+static void ucconfig_exit(void){
+
+    uint8_t byte;
+
+    //Nothing staged may be lost, whichever way the session ends
+    ucconfig_stageCommit();
+
+    //Without a terminate the bank written this session isn't used
+    ucconfig_bank = ucconfig_activeBank;
+
+    ucconfig_shadowLoad();
+
+    STRING11_setOutput(ucconfig_saved_print);
+    STRING11_setBlockOutput(ucconfig_saved_printBlock);
+    STRING11_setBuffer(ucconfig_saved_printBuffer,ucconfig_saved_printBufferSize);
+    FLASHWRITE_setOutput(ucconfig_saved_flashWrite);
+    FLASHWRITE_setInput(ucconfig_saved_flashRead);
+    FLASHWRITE_setBlockOutput(ucconfig_saved_blockWrite);
+    FLASHWRITE_setBlockInput(ucconfig_saved_blockRead);
+
+    //The listen context stops queueing before the FIFO is emptied, so nothing it queues is
+    //left for the next session. This also ends the active mode loop
+    atomic_store(&ucconfig_session,UCCONFIG_SESSION_IDLE);
+
+    //Anything still queued belongs to the finished session
+    while(FIFO8_spscPop(&ucconfig_fifo,&byte) == E_FIFO8_NOERROR);
+    ucconfig_state = UCCONFIG_STATE_COMMAND;
 }
 
 //Send not acknowledge
 void ucconfig_sendNack(){
 
     print((char)UCCONFIG_NACK);
-    print((char)UCCONFIG_NULL);
+    print((char)ucconfig_sequence);
     print((char)UCCONFIG_FRAME_END);
-    print((char)UCCONFIG_NEWLINE);
+    ucconfig_endFrame();
 }
 
 //Send acknowledge
 void ucconfig_sendAck(){
 
     print((char)UCCONFIG_ACK);
-    print((char)UCCONFIG_NULL);
+    print((char)ucconfig_sequence);
     print((char)UCCONFIG_FRAME_END);
-    print((char)UCCONFIG_NEWLINE);
+    ucconfig_endFrame();
 }
 
-//A frame end character was received
-//Check the fifo buffer the see if a valid command exists
-void ucconfig_parseCommand(){
+static void ucconfig_endFrame(void){
 
-    while(FIFO8_size(&ucconfig_fifo) > 0){
+    print((char)UCCONFIG_NEWLINE);
 
-        switch(FIFO8_pop(&ucconfig_fifo)){
+    //The whole frame in one block write, before anything else happens eg. a baud change
+    STRING11_flush();
+}
 
-            case UCCONFIG_FRAME_END:
+static uint8_t ucconfig_readSequence(uint8_t byte){
 
-                //Nothing valid in the frame
-                return;
-                break;
+    if((byte == UCCONFIG_NULL) || ((byte >= UCCONFIG_SEQUENCE_FIRST) && (byte <= UCCONFIG_SEQUENCE_LAST))){
 
-            case UCCONFIG_SET_MEMORY_ADDRESS:
+        ucconfig_sequence = byte;
+        return 1;
+    }
+    return 0;
+}
 
-                if(FIFO8_pop(&ucconfig_fifo) == UCCONFIG_NULL){
+//Called when a commit command is sent
+void ucconfig_commit(){
 
-                    ucconfig_set_address();
+    //Frame pos 3 is type, should be none for commit
+    if(ucconfig_frame.type != UCCONFIG_TYPE_NONE){
+        ucconfig_sendNack();
+        return;
+    }
 
-                    //Flush the rest of the FIFO
-                    while(FIFO8_size(&ucconfig_fifo) > 0){
-                        
-                        FIFO8_pop(&ucconfig_fifo);
-                    }
-                    return;
-                }
-                break;
+    //Length should be zero for commit
+    if(ucconfig_frame.length != 0){
 
-            case UCCONFIG_SET_WRITE_FRAME:
+        ucconfig_sendNack();
+        return;
+    }
 
-                if(FIFO8_pop(&ucconfig_fifo) == UCCONFIG_NULL){
+    ucconfig_stageCommit();
 
-                    ucconfig_write_data();
+    //Everything staged is in flash
+    ucconfig_sendAck();
+}
 
-                    //Flush the rest of the FIFO
-                    while(FIFO8_size(&ucconfig_fifo) > 0){
-                        
-                        FIFO8_pop(&ucconfig_fifo);
-                    }
-                    return;
-                }
-                break;
+//Called when a format command is sent
+//Responds with the storage format so the PC can encode and decode values
+void ucconfig_format(){
 
-            case UCCONFIG_READ_FRAME:
+    if((ucconfig_frame.type != UCCONFIG_TYPE_NONE) || (ucconfig_frame.length != 0)){
 
-                if(FIFO8_pop(&ucconfig_fifo) == UCCONFIG_NULL){
+        ucconfig_sendNack();
+        return;
+    }
 
-                    ucconfig_read_data();
+    print((char)UCCONFIG_FORMAT);
+    print((char)ucconfig_sequence);
+    print((char)UCCONFIG_TYPE_UINT8_T);
+    print((char)UCCONFIG_LENGTH_ZERO);
+    print((char)UCCONFIG_NOT_USED);
+    print((char)UCCONFIG_NOT_USED);
+    print((uint8_t)FLASHWRITE_FORMAT);
+    print((char)UCCONFIG_NULL);
+    print((char)UCCONFIG_FRAME_END);
+    ucconfig_endFrame();
+}
 
-                    //Flush the rest of the FIFO
-                    while(FIFO8_size(&ucconfig_fifo) > 0){
-                        
-                        FIFO8_pop(&ucconfig_fifo);
-                    }
-                    return;
-                }
-                break;
+//Called when a stats command is sent
+//Responds with the bytes programmed so far, staged pages are written first so they are counted
+void ucconfig_stats(){
 
-            case UCCONFIG_AT_ADDRESS:
+    if((ucconfig_frame.type != UCCONFIG_TYPE_NONE) || (ucconfig_frame.length != 0)){
 
-                if(FIFO8_pop(&ucconfig_fifo) == UCCONFIG_NULL){
+        ucconfig_sendNack();
+        return;
+    }
 
-                    ucconfig_get_address();
+    ucconfig_stageCommit();
 
-                    //Flush the rest of the FIFO
-                    while(FIFO8_size(&ucconfig_fifo) > 0){
-                        
-                        FIFO8_pop(&ucconfig_fifo);
-                    }
-                    return;
-                }
-                break;
+    print((char)UCCONFIG_STATS);
+    print((char)ucconfig_sequence);
+    print((char)UCCONFIG_TYPE_UINT32_T);
+    print((char)UCCONFIG_LENGTH_ZERO);
+    print((char)UCCONFIG_NOT_USED);
+    print((char)UCCONFIG_NOT_USED);
+    print(ucconfig_programmed);
+    print((char)UCCONFIG_NULL);
+    print((char)UCCONFIG_FRAME_END);
+    ucconfig_endFrame();
+}
 
-            case UCCONFIG_TERMINATE:
+static uint16_t ucconfig_stored16(const uint8_t *bytes){
 
-                if(FIFO8_pop(&ucconfig_fifo) == UCCONFIG_NULL){
-                    ucconfig_terminate();
-                    return;
-                }
-                break;
+    uint16_t value;
 
-            default:
-                break;
-        }
-    }
+#ifdef FLASHWRITE_NATIVE_ENDIAN
+    memcpy(&value,bytes,2);
+#else
+    value = (uint16_t)((bytes[0] << 8) | bytes[1]);
+#endif
+    return value;
 }
 
-//Setup the module
-void UCCONFIG_setup(uint8_t (*flash_read)(uint16_t address),void (*flash_write)(uint8_t byte, uint16_t address),void (*serial_write)(uint8_t byte)){
+static uint32_t ucconfig_stored32(const uint8_t *bytes){
 
-    //Assign Function pointers for flash operations
-    ucconfig_fp_flashRead = flash_read;
-    ucconfig_fp_flashWrite = flash_write;
+    uint32_t value;
 
-    //Assign function pointer for serial write
-    ucconfig_fp_serialWrite = serial_write;
+#ifdef FLASHWRITE_NATIVE_ENDIAN
+    memcpy(&value,bytes,4);
+#else
+    value = ((uint32_t)bytes[0] << 24) | ((uint32_t)bytes[1] << 16) | ((uint32_t)bytes[2] << 8) | bytes[3];
+#endif
+    return value;
+}
 
-    //Setup the received FIFO Object
-    FIFO8_init(&ucconfig_fifo,FIFO8_TRIGGER,ucconfig_fifo_buffer,UCCONFIG_FIFO_SIZE,&ucconfig_checkKey);
+#ifndef UCCONFIG_NO_FLOAT
+static double ucconfig_storedDouble(const uint8_t *bytes){
 
-    FLASHWRITE_setOutput(flash_write);
-    FLASHWRITE_setInput(flash_read);
+    double value;
 
-    //Initially inactive (running in background)
-    ucconfig_activeMode = 0;
+#ifdef FLASHWRITE_NATIVE_ENDIAN
+    memcpy(&value,bytes,8);
+#else
+    uint64_t data = ((uint64_t)ucconfig_stored32(bytes) << 32) | ucconfig_stored32(&bytes[4]);
+
+    memcpy(&value,&data,8);
+#endif
+    return value;
 }
+#endif
 
-//This is called each time a byte is flushed from the FIFO
-//Triggered by the UCCONFIG_listen when the FIFO has at least UCCONFIG_KEY_LENGTH bytes of key bytes
-//If the key combination is found calls ucconfig_active()
-void ucconfig_checkKey(uint8_t received){
+uint8_t UCCONFIG_setBanks(uint16_t bankA,uint16_t bankB,uint16_t size,void (*erase)(uint16_t address,uint16_t length)){
 
-    static uint8_t dump_pos = UCCONFIG_KEY_LENGTH;
+    uint16_t versionA;
+    uint16_t versionB;
+    uint8_t validA;
+    uint8_t validB;
 
-    if(FIFO8_size(&ucconfig_fifo) > UCCONFIG_KEY_LENGTH){
+    ucconfig_banks[0] = bankA;
+    ucconfig_banks[1] = bankB;
+    ucconfig_bankSize = size;
+    ucconfig_fp_bankErase = erase;
 
-        dump_pos = UCCONFIG_KEY_LENGTH;
-        return;
-    }
-    
-    switch(dump_pos){
+    validA = ucconfig_bankValid(0,&versionA);
+    validB = ucconfig_bankValid(1,&versionB);
 
-        case 4:
-            if(received == UCCONFIG_KEY_1){
+    //The newest valid bank is used, versions wrap
+    ucconfig_activeBank = (validB && (!validA || ((int16_t)(versionB - versionA) > 0))) ? 1 : 0;
+    ucconfig_bankVersion = ucconfig_activeBank ? versionB : versionA;
+    ucconfig_bank = ucconfig_activeBank;
 
-                if(FIFO8_size(&ucconfig_fifo) > UCCONFIG_KEY_LENGTH -1){
-                    dump_pos--;
-                }
-                else{
+    return validA || validB;
+}
 
-                    dump_pos = UCCONFIG_KEY_LENGTH;
-                }
-            }
-            else{
-                dump_pos = UCCONFIG_KEY_LENGTH;
-            }
-            break;
-        case 3:
-            if(received == UCCONFIG_KEY_2){
+static uint16_t ucconfig_bankAddress(uint16_t address){
 
-                if(FIFO8_size(&ucconfig_fifo) > UCCONFIG_KEY_LENGTH -2){
-                    dump_pos--;
-                }
-                else{
+    if(address < ucconfig_bankSize){
+        return ucconfig_banks[ucconfig_bank] + address;
+    }
 
-                    dump_pos = UCCONFIG_KEY_LENGTH;
-                }
-            }
-            else{
-                dump_pos = UCCONFIG_KEY_LENGTH;
-            }
-            break;
-        case 2:
-            if(received == UCCONFIG_KEY_3){
+    return address;
+}
 
-                if(FIFO8_size(&ucconfig_fifo) > UCCONFIG_KEY_LENGTH -3){
-                    dump_pos--;
-                }
-                else{
+static uint32_t ucconfig_bankCrc(uint8_t bank){
 
-                    dump_pos = UCCONFIG_KEY_LENGTH;
-                }
-            }
-            else{
-                dump_pos = UCCONFIG_KEY_LENGTH;
-            }
-            break;
-        case 1:
-            if(received == UCCONFIG_KEY_4){
+    uint32_t crc = 0xFFFFFFFF;
+    uint8_t data[16];
+    uint16_t offset;
+    uint16_t chunk;
 
-                //Sucsess
-                ucconfig_activeMode = UCCONFIG_ACTIVE_MODE_TIMEOUT;
-                dump_pos = UCCONFIG_KEY_LENGTH;
-                ucconfig_active();
-            }
-            else{
-                dump_pos = UCCONFIG_KEY_LENGTH;
-            }
-            break;
+    for(offset = 0; offset < ucconfig_bankSize; offset += chunk){
 
-        default:
-            dump_pos = UCCONFIG_KEY_LENGTH;
-            break;
+        chunk = ucconfig_bankSize - offset;
+        chunk = (chunk > sizeof(data)) ? sizeof(data) : chunk;
+        ucconfig_rawRead(ucconfig_banks[bank] + offset,data,chunk);
+        crc = ucconfig_crcUpdate(crc,data,chunk);
     }
+
+    return ~crc;
 }
 
-void UCCONFIG_listen(uint8_t received){
+static uint8_t ucconfig_bankValid(uint8_t bank,uint16_t *version){
 
-    //If in active mode, check if a frame end character was received.
-    if(ucconfig_activeMode){
+    uint8_t footer[UCCONFIG_BANK_FOOTER];
+    uint32_t crc;
 
-        //Reload the timeout
-        ucconfig_activeMode = UCCONFIG_ACTIVE_MODE_TIMEOUT;
+    ucconfig_rawRead(ucconfig_banks[bank] + ucconfig_bankSize,footer,UCCONFIG_BANK_FOOTER);
 
-        //Frame end receive, check if a valid command existed
-        if(received == UCCONFIG_FRAME_END){
+    if((footer[0] != 0x5A) || (footer[1] != 0xA5)){
+        return 0;
+    }
 
-            FIFO8_put(&ucconfig_fifo,received);
-            ucconfig_parseCommand();
-        }
-        else{
+    crc = ((uint32_t)footer[4] << 24) | ((uint32_t)footer[5] << 16) | ((uint32_t)footer[6] << 8) | footer[7];
 
-            //No frame end just fill the FIFO
-            FIFO8_put(&ucconfig_fifo,received);
-        }
-        return;
+    if(crc != ucconfig_bankCrc(bank)){
+        return 0;
     }
 
-    //Check if the character received is at the end of the key. If it is make sure
-    //There is enough characters in the fifo
-    if((received == UCCONFIG_KEY_4) && (FIFO8_size(&ucconfig_fifo) >= (UCCONFIG_KEY_LENGTH-1))){
+    *version = (uint16_t)((footer[2] << 8) | footer[3]);
+    return 1;
+}
+
+static void ucconfig_bankBegin(void){
 
-        FIFO8_put(&ucconfig_fifo,received);
-        FIFO8_flush(&ucconfig_fifo);
+    uint8_t target = !ucconfig_activeBank;
+    uint8_t data[16];
+    uint8_t stored[16];
+    uint16_t offset;
+    uint16_t chunk;
+
+    //The other bank stops being a valid config before any of it changes
+    if(ucconfig_fp_bankErase != NULL){
+
+        ucconfig_fp_bankErase(ucconfig_banks[target],ucconfig_bankSize + UCCONFIG_BANK_FOOTER);
     }
-    //Not enough characters, only append to the FIFO characters which are part of the key
     else{
 
-        switch(received){
+        memset(data,0,2);
+        ucconfig_rawWrite(ucconfig_banks[target] + ucconfig_bankSize,data,2);
+    }
 
-            case UCCONFIG_KEY_1:
-                FIFO8_put(&ucconfig_fifo,received);
-                break;
-            case UCCONFIG_KEY_2:
-                FIFO8_put(&ucconfig_fifo,received);
-                break;
-            case UCCONFIG_KEY_3:
-                FIFO8_put(&ucconfig_fifo,received);
-                break;
-            case UCCONFIG_KEY_4:
-                FIFO8_put(&ucconfig_fifo,received);
-                break;
-            default:
-                break;
+    //Variables the session doesn't write keep their values
+    for(offset = 0; offset < ucconfig_bankSize; offset += chunk){
+
+        chunk = ucconfig_bankSize - offset;
+        chunk = (chunk > sizeof(data)) ? sizeof(data) : chunk;
+        ucconfig_rawRead(ucconfig_banks[ucconfig_activeBank] + offset,data,chunk);
+
+        //Without an erase the other bank still holds an older config, much of which is the same
+        if(ucconfig_fp_bankErase == NULL){
+
+            ucconfig_rawRead(ucconfig_banks[target] + offset,stored,chunk);
+
+            if(memcmp(data,stored,chunk) == 0){
+                continue;
+            }
         }
+
+        ucconfig_rawWrite(ucconfig_banks[target] + offset,data,chunk);
     }
-    return;
+
+    ucconfig_bank = target;
+}
+
+static void ucconfig_bankCommit(void){
+
+    uint8_t footer[UCCONFIG_BANK_FOOTER];
+    uint32_t crc;
+
+    if((ucconfig_bankSize == 0) || (ucconfig_bank == ucconfig_activeBank)){
+        return;
+    }
+
+    //The CRC is of what is in flash
+    ucconfig_stageCommit();
+
+    crc = ucconfig_bankCrc(ucconfig_bank);
+    ucconfig_bankVersion++;
+
+    footer[0] = 0x5A;
+    footer[1] = 0xA5;
+    footer[2] = (uint8_t)(ucconfig_bankVersion >> 8);
+    footer[3] = (uint8_t)ucconfig_bankVersion;
+    footer[4] = (uint8_t)(crc >> 24);
+    footer[5] = (uint8_t)(crc >> 16);
+    footer[6] = (uint8_t)(crc >> 8);
+    footer[7] = (uint8_t)crc;
+
+    //A footer which isn't completely written fails its check, leaving the old bank in use
+    ucconfig_rawWrite(ucconfig_banks[ucconfig_bank] + ucconfig_bankSize,footer,UCCONFIG_BANK_FOOTER);
+    ucconfig_activeBank = ucconfig_bank;
+}
+
+//Called when a rollback command is sent
+//Anything written this session is dropped and the other bank is used if it's valid
+void ucconfig_rollback(){
+
+    uint8_t other = !ucconfig_activeBank;
+    uint16_t version;
+    uint8_t clear[2] = {0,0};
+    uint8_t page;
+
+    if((ucconfig_frame.type != UCCONFIG_TYPE_NONE) || (ucconfig_frame.length != 0) || (ucconfig_bankSize == 0)){
+
+        ucconfig_sendNack();
+        return;
+    }
+
+    //Staged pages belong to the bank being abandoned
+    for(page = 0; page < ucconfig_stageCount; page++){
+        ucconfig_stages[page].used = 0;
+    }
+
+    ucconfig_bank = ucconfig_activeBank;
+    ucconfig_written = 0;
+
+    //Once this session has written the other bank it no longer holds the previous config
+    if(!ucconfig_bankValid(other,&version)){
+
+        ucconfig_shadowLoad();
+        ucconfig_sendNack();
+        return;
+    }
+
+    ucconfig_rawWrite(ucconfig_banks[ucconfig_activeBank] + ucconfig_bankSize,clear,2);
+
+    ucconfig_activeBank = other;
+    ucconfig_bank = other;
+    ucconfig_bankVersion = version;
+    ucconfig_shadowLoad();
+
+    ucconfig_sendAck();
+}
+
+uint8_t UCCONFIG_setStaging(uint8_t *buffer,uint16_t size,uint16_t pageSize){
+
+    //Anything staged with the old buffer goes to flash first
+    ucconfig_stageCommit();
+    ucconfig_stageCount = 0;
+    ucconfig_fp_pageErase = NULL;
+
+    if((buffer == NULL) || !(pageSize && !(pageSize & (pageSize - 1))) || (size < pageSize)){
+        return 0;
+    }
+
+    ucconfig_stagingBuffer = buffer;
+    ucconfig_pageSize = pageSize;
+    ucconfig_stageCount = (size / pageSize > UCCONFIG_STAGING_MAX_PAGES) ? UCCONFIG_STAGING_MAX_PAGES : size / pageSize;
+    ucconfig_nextEvict = 0;
+
+    return 1;
+}
+
+uint8_t UCCONFIG_setGeometry(uint16_t pageSize,void (*erase)(uint16_t address),uint8_t erasedValue){
+
+    ucconfig_fp_pageErase = NULL;
+
+    //The staged copy of a page is what gets programmed back after it is erased
+    if((erase == NULL) || (ucconfig_stageCount == 0) || (pageSize != ucconfig_pageSize)){
+        return 0;
+    }
+
+    ucconfig_fp_pageErase = erase;
+    ucconfig_erasedValue = erasedValue;
+
+    return 1;
+}
+
+static uint8_t ucconfig_stageFind(uint16_t address){
+
+    uint8_t page;
+
+    for(page = 0; page < ucconfig_stageCount; page++){
+
+        if(ucconfig_stages[page].used && (ucconfig_stages[page].address == (address & ~(ucconfig_pageSize - 1)))){
+            return page;
+        }
+    }
+
+    return UCCONFIG_STAGING_MAX_PAGES;
+}
+
+static void ucconfig_stageWrite(uint8_t byte,uint16_t address){
+
+    uint8_t page = ucconfig_stageFind(address);
+    uint8_t *data;
+    uint16_t offset;
+
+    //Staging was turned off part way through a session
+    if(ucconfig_stageCount == 0){
+
+        ucconfig_flashWriteBlock(address,&byte,1);
+        return;
+    }
+
+    if(page == UCCONFIG_STAGING_MAX_PAGES){
+
+        //Use a free page, or make one free by writing the oldest to flash
+        for(page = 0; page < ucconfig_stageCount; page++){
+
+            if(!ucconfig_stages[page].used){
+                break;
+            }
+        }
+
+        if(page == ucconfig_stageCount){
+
+            page = ucconfig_nextEvict;
+            ucconfig_nextEvict = (ucconfig_nextEvict + 1) % ucconfig_stageCount;
+            ucconfig_stageFlush(page);
+        }
+
+        //Load the whole page so bytes between the dirty ones are written back unchanged
+        data = &ucconfig_stagingBuffer[page * ucconfig_pageSize];
+        ucconfig_stages[page].address = address & ~(ucconfig_pageSize - 1);
+
+        ucconfig_flashReadBlock(ucconfig_stages[page].address,data,ucconfig_pageSize);
+
+        ucconfig_stages[page].dirtyStart = 0;
+        ucconfig_stages[page].dirtyEnd = 0;
+        ucconfig_stages[page].used = 1;
+    }
+
+    data = &ucconfig_stagingBuffer[page * ucconfig_pageSize];
+    offset = address & (ucconfig_pageSize - 1);
+
+    //Writing the value already staged doesn't make the byte dirty
+    if(data[offset] == byte){
+        return;
+    }
+
+    data[offset] = byte;
+
+    //Grow the dirty range to cover the byte
+    if(ucconfig_stages[page].dirtyStart == ucconfig_stages[page].dirtyEnd){
+
+        ucconfig_stages[page].dirtyStart = offset;
+        ucconfig_stages[page].dirtyEnd = offset + 1;
+    }
+    else if(offset < ucconfig_stages[page].dirtyStart){
+
+        ucconfig_stages[page].dirtyStart = offset;
+    }
+    else if(offset >= ucconfig_stages[page].dirtyEnd){
+
+        ucconfig_stages[page].dirtyEnd = offset + 1;
+    }
+}
+
+static uint8_t ucconfig_stageRead(uint16_t address){
+
+    uint8_t page = ucconfig_stageFind(address);
+
+    uint8_t byte;
+
+    if(page == UCCONFIG_STAGING_MAX_PAGES){
+
+        ucconfig_flashReadBlock(address,&byte,1);
+        return byte;
+    }
+
+    return ucconfig_stagingBuffer[page * ucconfig_pageSize + (address & (ucconfig_pageSize - 1))];
+}
+
+static void ucconfig_stageFlush(uint8_t page){
+
+    uint8_t *data = &ucconfig_stagingBuffer[page * ucconfig_pageSize];
+    uint16_t start = ucconfig_stages[page].dirtyStart;
+    uint16_t end = ucconfig_stages[page].dirtyEnd;
+
+    if(end > start){
+
+        //The changed part of the page in a single write, unless it can't be programmed over
+        if((ucconfig_fp_pageErase != NULL) && !ucconfig_pageBlank(ucconfig_stages[page].address + start,&data[start],end - start)){
+
+            ucconfig_pageRewrite(page);
+        }
+        else{
+
+            ucconfig_flashWriteBlock(ucconfig_stages[page].address + start,&data[start],end - start);
+        }
+    }
+
+    ucconfig_stages[page].used = 0;
+}
+
+static uint8_t ucconfig_pageBlank(uint16_t address,const uint8_t *data,uint16_t length){
+
+    uint8_t current[16];
+    const uint8_t *stored;
+    uint16_t offset;
+    uint16_t chunk;
+    uint16_t i;
+
+    for(offset = 0; offset < length; offset += chunk){
+
+        chunk = length - offset;
+        chunk = (chunk > sizeof(current)) ? sizeof(current) : chunk;
+
+        stored = ucconfig_shadowBytes(address + offset,chunk);
+
+        if(stored == NULL){
+
+            ucconfig_flashReadBlock(address + offset,current,chunk);
+            stored = current;
+        }
+
+        for(i = 0; i < chunk; i++){
+
+            if((stored[i] != data[offset + i]) && (stored[i] != ucconfig_erasedValue)){
+                return 0;
+            }
+        }
+    }
+
+    return 1;
+}
+
+static void ucconfig_pageRewrite(uint8_t page){
+
+    uint8_t *data = &ucconfig_stagingBuffer[page * ucconfig_pageSize];
+    uint16_t first;
+    uint16_t last;
+
+    //The session writes the other bank, the active one is never erased
+    if((ucconfig_bankSize > 0) && (ucconfig_bank == ucconfig_activeBank)){
+        ucconfig_bankBegin();
+    }
+
+    ucconfig_fp_pageErase(ucconfig_bankAddress(ucconfig_stages[page].address));
+
+    //The erased bytes at either end already hold their value
+    for(first = 0; (first < ucconfig_pageSize) && (data[first] == ucconfig_erasedValue); first++);
+    for(last = ucconfig_pageSize; (last > first) && (data[last - 1] == ucconfig_erasedValue); last--);
+
+    //Straight to flash, none of it can be skipped after the erase
+    ucconfig_shadowWrite(ucconfig_stages[page].address,data,ucconfig_pageSize);
+
+    if(last > first){
+        ucconfig_rawWrite(ucconfig_bankAddress(ucconfig_stages[page].address + first),&data[first],last - first);
+    }
+}
+
+static void ucconfig_flashReadBlock(uint16_t address,uint8_t *data,uint16_t length){
+
+    ucconfig_rawRead(ucconfig_bankAddress(address),data,length);
+}
+
+static void ucconfig_rawRead(uint16_t address,uint8_t *data,uint16_t length){
+
+    uint16_t i;
+
+    if(ucconfig_fp_blockRead != NULL){
+
+        ucconfig_fp_blockRead(address,data,length);
+        return;
+    }
+
+    for(i = 0; i < length; i++){
+        data[i] = ucconfig_fp_flashRead(address + i);
+    }
+}
+
+static void ucconfig_flashWriteBlock(uint16_t address,const uint8_t *data,uint16_t length){
+
+    uint8_t current[16];
+    const uint8_t *stored;
+    uint16_t offset;
+    uint16_t chunk;
+    uint16_t run;
+    uint16_t i;
+
+    //Only runs of bytes which differ from what is stored are programmed, run is length while there isn't one
+    run = length;
+
+    for(offset = 0; offset < length; offset += chunk){
+
+        chunk = length - offset;
+        chunk = (chunk > sizeof(current)) ? sizeof(current) : chunk;
+
+        stored = ucconfig_shadowBytes(address + offset,chunk);
+
+        if(stored == NULL){
+
+            ucconfig_flashReadBlock(address + offset,current,chunk);
+            stored = current;
+        }
+
+        for(i = 0; i < chunk; i++){
+
+            if(stored[i] != data[offset + i]){
+
+                if(run == length){
+                    run = offset + i;
+                }
+            }
+            else if(run != length){
+
+                ucconfig_flashProgram(address + run,&data[run],offset + i - run);
+                run = length;
+            }
+        }
+    }
+
+    if(run != length){
+        ucconfig_flashProgram(address + run,&data[run],length - run);
+    }
+}
+
+static void ucconfig_flashProgram(uint16_t address,const uint8_t *data,uint16_t length){
+
+    //The other bank becomes a copy of the active one once something actually changes
+    if((ucconfig_bankSize > 0) && (ucconfig_bank == ucconfig_activeBank)){
+        ucconfig_bankBegin();
+    }
+
+    ucconfig_shadowWrite(address,data,length);
+    ucconfig_rawWrite(ucconfig_bankAddress(address),data,length);
+}
+
+static void ucconfig_shadowWrite(uint16_t address,const uint8_t *data,uint16_t length){
+
+    uint16_t i;
+
+    //Keep the shadow the same as flash, only the overlapping part is copied
+    for(i = 0; i < length; i++){
+
+        if((uint16_t)(address + i - ucconfig_shadowAddress) < ucconfig_shadowSize){
+            ucconfig_shadow[(uint16_t)(address + i - ucconfig_shadowAddress)] = data[i];
+        }
+    }
+}
+
+static void ucconfig_rawWrite(uint16_t address,const uint8_t *data,uint16_t length){
+
+    uint16_t i;
+
+    ucconfig_programmed += length;
+
+    if(ucconfig_fp_blockWrite != NULL){
+
+        ucconfig_fp_blockWrite(address,data,length);
+        return;
+    }
+
+    for(i = 0; i < length; i++){
+        ucconfig_fp_flashWrite(data[i],address + i);
+    }
+}
+
+static void ucconfig_stageCommit(void){
+
+    uint8_t page;
+
+    for(page = 0; page < ucconfig_stageCount; page++){
+
+        if(ucconfig_stages[page].used){
+            ucconfig_stageFlush(page);
+        }
+    }
+
+    ucconfig_nextEvict = 0;
+}
+
+//Called for every byte received while in config mode
+//Each byte is checked as it arrives so the work per byte is the same for any frame
+static void ucconfig_parseByte(uint8_t byte){
+
+    //Data never contains a frame end, so it always finishes the frame
+    if((byte == UCCONFIG_FRAME_END) && (ucconfig_state != UCCONFIG_STATE_FRAME_END)){
+
+        //Respond to a frame which was cut short
+        if((ucconfig_state != UCCONFIG_STATE_COMMAND) &&
+           (ucconfig_state != UCCONFIG_STATE_SEQUENCE) &&
+           (ucconfig_state != UCCONFIG_STATE_SKIP)){
+
+            ucconfig_sendNack();
+        }
+
+        ucconfig_state = UCCONFIG_STATE_COMMAND;
+        return;
+    }
+
+    switch(ucconfig_state){
+
+        case UCCONFIG_STATE_COMMAND:
+
+            //Anything before a command character is ignored
+            if(ucconfig_isCommand(byte)){
+
+                ucconfig_frame.command = byte;
+                ucconfig_state = UCCONFIG_STATE_SEQUENCE;
+            }
+            break;
+
+        case UCCONFIG_STATE_SEQUENCE:
+
+            //Without NULL or a sequence it wasn't a command, look for the next one
+            if(ucconfig_readSequence(byte)){
+                ucconfig_state = UCCONFIG_STATE_TYPE;
+            }
+            else{
+                ucconfig_state = UCCONFIG_STATE_COMMAND;
+            }
+            break;
+
+        case UCCONFIG_STATE_TYPE:
+
+            //Data type is checked by the command
+            ucconfig_frame.type = byte;
+            ucconfig_state = UCCONFIG_STATE_LENGTH;
+            break;
+
+        case UCCONFIG_STATE_LENGTH:
+
+            //Length is the capital letter of the aplphabet. eg. A = 1, C = 3
+            if(byte == UCCONFIG_LENGTH_ZERO){
+                ucconfig_frame.length = 0;
+            }
+            else if((byte > 64) && (byte <= 64 + UCCONFIG_BULK_MAX_LENGTH)){
+                ucconfig_frame.length = byte - 64;
+            }
+            else{
+                ucconfig_frameError();
+                break;
+            }
+
+            ucconfig_frame.received = 0;
+            ucconfig_state = UCCONFIG_STATE_NOT_USED_1;
+            break;
+
+        case UCCONFIG_STATE_NOT_USED_1:
+
+            //Next two should be not used charaters
+            if(byte != UCCONFIG_NOT_USED){
+                ucconfig_frameError();
+                break;
+            }
+            ucconfig_state = UCCONFIG_STATE_NOT_USED_2;
+            break;
+
+        case UCCONFIG_STATE_NOT_USED_2:
+
+            if(byte != UCCONFIG_NOT_USED){
+                ucconfig_frameError();
+                break;
+            }
+
+            if(ucconfig_frame.length == 0){
+                ucconfig_frame.data[0] = 0;
+                ucconfig_state = UCCONFIG_STATE_NULL;
+            }
+            else{
+                ucconfig_state = UCCONFIG_STATE_DATA;
+            }
+            break;
+
+        case UCCONFIG_STATE_DATA:
+
+            ucconfig_frame.data[ucconfig_frame.received++] = byte;
+
+            //Add a null character once all the data is in
+            if(ucconfig_frame.received == ucconfig_frame.length){
+
+                ucconfig_frame.data[ucconfig_frame.received] = 0;
+                ucconfig_state = UCCONFIG_STATE_NULL;
+            }
+            break;
+
+        case UCCONFIG_STATE_NULL:
+
+            //Null should follow data
+            if(byte != UCCONFIG_NULL){
+                ucconfig_frameError();
+                break;
+            }
+            ucconfig_state = UCCONFIG_STATE_FRAME_END;
+            break;
+
+        case UCCONFIG_STATE_FRAME_END:
+
+            if(byte != UCCONFIG_FRAME_END){
+                ucconfig_frameError();
+                break;
+            }
+
+            //Set before running, terminate starts the next session's parsing
+            ucconfig_state = UCCONFIG_STATE_COMMAND;
+            ucconfig_runCommand();
+            break;
+
+        default:
+            //Skipping an invalid frame
+            break;
+    }
+}
+
+static void ucconfig_frameError(void){
+
+    ucconfig_sendNack();
+    ucconfig_state = UCCONFIG_STATE_SKIP;
+}
+
+static uint8_t ucconfig_isCommand(uint8_t byte){
+
+    switch(byte){
+
+        case UCCONFIG_SET_MEMORY_ADDRESS:
+        case UCCONFIG_SET_WRITE_FRAME:
+        case UCCONFIG_BULK_WRITE_FRAME:
+        case UCCONFIG_READ_FRAME:
+        case UCCONFIG_READ_BLOCK_FRAME:
+        case UCCONFIG_CRC_FRAME:
+        case UCCONFIG_SET_BAUD:
+        case UCCONFIG_COMMIT:
+        case UCCONFIG_FORMAT:
+        case UCCONFIG_ROLLBACK:
+        case UCCONFIG_STATS:
+        case UCCONFIG_AT_ADDRESS:
+        case UCCONFIG_TERMINATE:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+//A complete and correctly framed command was received
+void ucconfig_runCommand(void){
+
+    switch(ucconfig_frame.command){
+
+        case UCCONFIG_SET_MEMORY_ADDRESS:
+            ucconfig_set_address();
+            break;
+        case UCCONFIG_SET_WRITE_FRAME:
+            ucconfig_write_data();
+            break;
+        case UCCONFIG_BULK_WRITE_FRAME:
+            ucconfig_bulk_write_data();
+            break;
+        case UCCONFIG_READ_FRAME:
+            ucconfig_read_data();
+            break;
+        case UCCONFIG_READ_BLOCK_FRAME:
+            ucconfig_read_block();
+            break;
+        case UCCONFIG_CRC_FRAME:
+            ucconfig_crc_block();
+            break;
+        case UCCONFIG_SET_BAUD:
+            ucconfig_set_baud();
+            break;
+        case UCCONFIG_COMMIT:
+            ucconfig_commit();
+            break;
+        case UCCONFIG_FORMAT:
+            ucconfig_format();
+            break;
+        case UCCONFIG_ROLLBACK:
+            ucconfig_rollback();
+            break;
+        case UCCONFIG_STATS:
+            ucconfig_stats();
+            break;
+        case UCCONFIG_AT_ADDRESS:
+            ucconfig_get_address();
+            break;
+        case UCCONFIG_TERMINATE:
+            ucconfig_terminate();
+            break;
+        default:
+            break;
+    }
+}
+
+//Setup the module
+void UCCONFIG_setup(uint8_t (*flash_read)(uint16_t address),void (*flash_write)(uint8_t byte, uint16_t address),void (*serial_write)(uint8_t byte)){
+
+    //Assign Function pointers for flash operations, UCCONFIG_setupBlock() adds block ones after
+    ucconfig_fp_flashRead = flash_read;
+    ucconfig_fp_flashWrite = flash_write;
+    ucconfig_fp_blockRead = NULL;
+    ucconfig_fp_blockWrite = NULL;
+
+    //Assign function pointer for serial write
+    ucconfig_fp_serialWrite = serial_write;
+
+    //Software CRC unless a hardware one is set later
+    ucconfig_fp_crc = ucconfig_crc32;
+
+    //Setup the received FIFO Object
+    FIFO8_spscInit(&ucconfig_fifo,ucconfig_fifo_buffer,UCCONFIG_FIFO_SIZE);
+
+    FLASHWRITE_setOutput(flash_write);
+    FLASHWRITE_setInput(flash_read);
+
+    //Initially inactive (running in background)
+    atomic_store(&ucconfig_session,UCCONFIG_SESSION_IDLE);
+}
+
+void UCCONFIG_setupBlock(void (*flash_read)(uint16_t address,uint8_t *data,uint16_t length),void (*flash_write)(uint16_t address,const uint8_t *data,uint16_t length),void (*serial_write)(uint8_t byte)){
+
+    UCCONFIG_setup(NULL,NULL,serial_write);
+
+    //Every flash access goes through the block functions, so the byte ones are never used
+    ucconfig_fp_blockRead = flash_read;
+    ucconfig_fp_blockWrite = flash_write;
+
+    FLASHWRITE_setBlockOutput(flash_write);
+    FLASHWRITE_setBlockInput(flash_read);
+}
+
+void UCCONFIG_listen(uint8_t received){
+
+    //Once the key is found, queue the byte for parsing
+    if(atomic_load(&ucconfig_session) != UCCONFIG_SESSION_IDLE){
+
+        //Queue the byte, UCCONFIG_loop() parses it
+        FIFO8_spscPut(&ucconfig_fifo,received);
+
+        //Restarts the timeout, this is the only writer so a load and store is enough
+        atomic_store(&ucconfig_received,atomic_load(&ucconfig_received) + 1);
+        return;
+    }
+
+    //Match the key one character at a time, characters which aren't part of the key are ignored
+    switch(received){
+
+        case UCCONFIG_KEY_1:
+            ucconfig_keyPos = 1;
+            break;
+        case UCCONFIG_KEY_2:
+            ucconfig_keyPos = (ucconfig_keyPos == 1) ? 2 : 0;
+            break;
+        case UCCONFIG_KEY_3:
+            ucconfig_keyPos = (ucconfig_keyPos == 2) ? 3 : 0;
+            break;
+        case UCCONFIG_KEY_4:
+            ucconfig_keyPos = (ucconfig_keyPos == 3) ? UCCONFIG_KEY_LENGTH : 0;
+            break;
+        default:
+            break;
+    }
+
+    //Sucsess, the key is never queued. Config mode is started by the consumer, UCCONFIG_loop() or UCCONFIG_poll()
+    if(ucconfig_keyPos == UCCONFIG_KEY_LENGTH){
+
+        ucconfig_keyPos = 0;
+        atomic_store(&ucconfig_session,UCCONFIG_SESSION_KEYED);
+    }
+    return;
+}
+
+void UCCONFIG_listen_buffer(const uint8_t *data, size_t length){
+
+    //Look for the key until config mode starts
+    while((length > 0) && (atomic_load(&ucconfig_session) == UCCONFIG_SESSION_IDLE)){
+
+        UCCONFIG_listen(*data++);
+        length--;
+    }
+
+    if(length == 0){
+        return;
+    }
+
+    //Queue everything left, no more than the FIFO size can fit anyway
+    if(length > UCCONFIG_FIFO_SIZE){
+        length = UCCONFIG_FIFO_SIZE;
+    }
+
+    FIFO8_spscPutn(&ucconfig_fifo,data,(uint16_t)length);
+
+    //Restarts the timeout
+    atomic_store(&ucconfig_received,atomic_load(&ucconfig_received) + 1);
 }
@@ -1,5 +1,5 @@
 #ifndef UCCONFIG_H
-#define UCCONFIG_H_
+#define UCCONFIG_H
 
 /**
     @addtogroup COMMON
@@ -41,6 +41,13 @@
     The python module generates the header file which is included in the example program
     @include example_variables.h
 
+    @par Targets without an FPU
+    Fixed point (qM.N) variables are stored as an int16_t or int32_t and read with integer code only,
+    see UCCONFIG_Q_MUL(). Defining UCCONFIG_NO_FLOAT when building leaves the float and double types out
+    of the module, float frames are then not acknowledged and reading a float or double variable doesn't
+    compile. FLASHWRITE_NO_FLOAT and STRING11_NO_FLOAT
+    do the same for those modules, they require UCCONFIG_NO_FLOAT.
+
  * @{
  */
 
@@ -52,6 +59,11 @@
 #include <flashWrite.h>
 #include <fifo8.h>
 #include <stdio.h>
+#include <string.h>
+
+#if (defined(FLASHWRITE_NO_FLOAT) || defined(STRING11_NO_FLOAT)) && !defined(UCCONFIG_NO_FLOAT)
+#error "FLASHWRITE_NO_FLOAT and STRING11_NO_FLOAT require UCCONFIG_NO_FLOAT"
+#endif
 
 /*!
     @brief The length of the key which the PC needs to send to enter Config mode
@@ -74,9 +86,12 @@
 */
 #define UCCONFIG_KEY_4  8
 /*!
-    @brief The size of the FIFO used by the module, don't change this
+    @brief The size of the FIFO used by the module, must be a power of 2.
+    @details Received bytes are queued here until UCCONFIG_loop() parses them. Frames are
+    parsed a byte at a time so they don't have to fit, but it should hold what arrives
+    during the slowest command, eg. a bulk write, for the PC to keep a frame in flight.
 */
-#define UCCONFIG_FIFO_SIZE 32
+#define UCCONFIG_FIFO_SIZE 256
 
 /*!
     @brief The frame and character
@@ -102,6 +117,59 @@
     @brief Command used get the current memory addresss pointer
 */
 #define UCCONFIG_AT_ADDRESS 16
+/*!
+    @brief Command used to write a run of consecutive variables in a single frame
+    @details The payload is a sequence of type characters, each followed by the
+    ASCII value for that type. Values are written from the current memory address.
+*/
+#define UCCONFIG_BULK_WRITE_FRAME 23
+/*!
+    @brief Maximum number of payload characters in a bulk write frame
+*/
+#define UCCONFIG_BULK_MAX_LENGTH 96
+/*!
+    @brief Command used to read a block of raw bytes from the current memory address
+    @details The frame data is the number of bytes to read. The response carries
+    each byte as two uppercase hexadecimal characters so it can't contain frame characters.
+*/
+#define UCCONFIG_READ_BLOCK_FRAME 24
+/*!
+    @brief Command used to get the CRC of a region starting at the current memory address
+    @details The frame data is the number of bytes in the region, the memory address isn't moved.
+    The response carries the CRC as a uint32_t, see UCCONFIG_setCrc().
+*/
+#define UCCONFIG_CRC_FRAME 25
+/*!
+    @brief Command used to change the serial baud rate for the rest of the session
+    @details The frame data is the baud rate. The acknowledge is sent at the current rate before
+    switching. The PC then sends the same frame at the new rate to confirm it, if that doesn't
+    arrive within #UCCONFIG_BAUD_CONFIRM_TIMEOUT (#UCCONFIG_BAUD_CONFIRM_MS with a clock) the previous rate
+    is restored. See UCCONFIG_setBaud().
+*/
+#define UCCONFIG_SET_BAUD 26
+/*!
+    @brief Command used to write staged pages to flash
+    @details The acknowledge is sent once every dirty page has been written, see UCCONFIG_setStaging().
+    Without a staging buffer it is acknowledged straight away.
+*/
+#define UCCONFIG_COMMIT 27
+/*!
+    @brief Command used to get the storage format of multi byte values
+    @details The response carries #FLASHWRITE_FORMAT as a uint8_t. A UC without this command
+    doesn't respond, the PC then uses big endian.
+*/
+#define UCCONFIG_FORMAT 28
+/*!
+    @brief Command used to go back to the config in the other bank, see UCCONFIG_setBanks()
+    @details Acknowledged if the other bank holds a valid config and nothing has been written this session.
+*/
+#define UCCONFIG_ROLLBACK 29
+/*!
+    @brief Command used to get the number of bytes programmed this session
+    @details Anything staged is written to flash first. The response carries the count as a uint32_t,
+    bytes which already held the value written aren't programmed or counted.
+*/
+#define UCCONFIG_STATS 30
 /*!
     @brief Command used to acknowledge a command
 */
@@ -110,6 +178,17 @@
     @brief Command used to not acknowledge a command
 */
 #define UCCONFIG_NACK 18
+/*!
+    @brief First character used for frame sequence numbers
+    @details The PC can send a sequence character in place of the NULL following the command.
+    The same character is echoed in place of the NULL in the response, so responses to
+    pipelined frames can be matched to the frame which caused them.
+*/
+#define UCCONFIG_SEQUENCE_FIRST 64
+/*!
+    @brief Last character used for frame sequence numbers
+*/
+#define UCCONFIG_SEQUENCE_LAST 127
 /*!
     @brief ASCII character used for NULL
 */
@@ -167,8 +246,48 @@
     @brief Number of loop iterratios before automattically exits from active mode
 */
 #define UCCONFIG_ACTIVE_MODE_TIMEOUT 0xFFFF
+/*!
+    @brief Number of idle loop iterations to wait for a new baud rate to be confirmed
+*/
+#define UCCONFIG_BAUD_CONFIRM_TIMEOUT 0x3FF
+/*!
+    @brief Milliseconds without a received byte before automattically exiting active mode
+    @details Used by UCCONFIG_poll() in place of #UCCONFIG_ACTIVE_MODE_TIMEOUT.
+*/
+#define UCCONFIG_TIMEOUT_MS 5000
+/*!
+    @brief Milliseconds to wait for a new baud rate to be confirmed
+    @details Used by UCCONFIG_poll() in place of #UCCONFIG_BAUD_CONFIRM_TIMEOUT. Should be shorter than the
+    time the PC waits for a response, so the UC is back at the old rate when the PC gives up.
+*/
+#define UCCONFIG_BAUD_CONFIRM_MS 200
+/*!
+    @brief Bytes following the data of each bank, marker, version and CRC-32, see UCCONFIG_setBanks()
+*/
+#define UCCONFIG_BANK_FOOTER 8
+
+/*!
+    @brief Size of the buffer response frames are collected in, see UCCONFIG_setSerialBlock()
+    @details A longer frame, eg. a read block response, is sent in more than one block write.
+*/
+#define UCCONFIG_TX_BUFFER_SIZE 64
+
+/*!
+    @brief Maximum number of pages held by the staging buffer, see UCCONFIG_setStaging()
+*/
+#define UCCONFIG_STAGING_MAX_PAGES 8
 
 
+#ifdef UCCONFIG_NO_FLOAT
+/*!
+    @brief Used for float and double variables with UCCONFIG_NO_FLOAT, it isn't a function
+    @details UCCONFIG_get() or UCCONFIG_decode() of a float or double then fails to compile with
+    "called object is not a function", rather than reading the bytes as another type.
+    It is never defined.
+*/
+extern const uint8_t ucconfig_noFloat;
+#endif
+
 /*!
     @brief UCCONFIG_GET() is the function macro used to get the value of any
     variable type in flash.
@@ -180,6 +299,7 @@
     @warning There is no type checking of the variable fetched. Make sure that at the
     given memory location there is that type of variable.
 */
+#ifndef UCCONFIG_MEMORY_MAPPED
 #define UCCONFIG_get(X,Y) _Generic((X),                                \
                                     char*:     ucconfig_get_c,      \
                                     uint8_t*:  ucconfig_get_u8,     \
@@ -188,10 +308,139 @@
                                     int16_t*:  ucconfig_get_16,     \
                                     uint32_t*: ucconfig_get_u32,    \
                                     int32_t*:  ucconfig_get_32,     \
-                                    float*:    ucconfig_get_float,  \
+                                    UCCONFIG_GET_FLOAT              \
                                     default:   ucconfig_get_u8      \
                                                                )(X,Y)
 
+#ifndef UCCONFIG_NO_FLOAT
+#define UCCONFIG_GET_FLOAT float*: ucconfig_get_float, double*: ucconfig_get_double,
+#else
+#define UCCONFIG_GET_FLOAT float*: ucconfig_noFloat, double*: ucconfig_noFloat,
+#endif
+#else
+
+#ifndef UCCONFIG_MEMORY_BASE
+#error "UCCONFIG_MEMORY_MAPPED requires UCCONFIG_MEMORY_BASE, the CPU address of flash address 0"
+#endif
+
+/*!
+    @brief With UCCONFIG_MEMORY_MAPPED defined UCCONFIG_get() reads flash directly through the CPU address space.
+    @details For flash which is mapped into memory, eg. the STM32 internal flash. Define UCCONFIG_MEMORY_MAPPED and
+    UCCONFIG_MEMORY_BASE, the CPU address of flash address 0 (what the read function adds to the address), when building
+    both the module and the program. Each UCCONFIG_get() is then a volatile load and a byte swap with no function call,
+    and UCCONFIG_read() is a copy. The read functions, the shadow and the staging buffer aren't used for these reads.
+    @warning Multi byte loads must be allowed at the variable addresses. Generate the header with the aligned
+    layout (python -a option) for cores without unaligned access, eg. Cortex-M0.
+*/
+#define UCCONFIG_get(X,Y) _Generic((X),                                \
+                                    char*:     ucconfig_mapped_c,   \
+                                    uint8_t*:  ucconfig_mapped_u8,  \
+                                    int8_t*:   ucconfig_mapped_8,   \
+                                    uint16_t*: ucconfig_mapped_u16, \
+                                    int16_t*:  ucconfig_mapped_16,  \
+                                    uint32_t*: ucconfig_mapped_u32, \
+                                    int32_t*:  ucconfig_mapped_32,  \
+                                    UCCONFIG_MAPPED_FLOAT           \
+                                    default:   ucconfig_mapped_u8   \
+                                                               )(X,Y)
+
+#ifndef UCCONFIG_NO_FLOAT
+#define UCCONFIG_MAPPED_FLOAT float*: ucconfig_mapped_float, double*: ucconfig_mapped_double,
+#else
+#define UCCONFIG_MAPPED_FLOAT float*: ucconfig_noFloat, double*: ucconfig_noFloat,
+#endif
+
+/*!
+    @brief The value of type T stored at flash address A, read through the memory map.
+*/
+#define UCCONFIG_MAPPED(T,A) (*(volatile const T*)((uintptr_t)(UCCONFIG_MEMORY_BASE) + (A)))
+
+/*!
+    @brief Convert a value loaded from flash to CPU order, nothing to do with #FLASHWRITE_NATIVE_ENDIAN.
+*/
+#if defined(FLASHWRITE_NATIVE_ENDIAN) || (defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__))
+#define UCCONFIG_BE16(X) (X)
+#define UCCONFIG_BE32(X) (X)
+#define UCCONFIG_BE64(X) (X)
+#else
+#define UCCONFIG_BE16(X) __builtin_bswap16(X)
+#define UCCONFIG_BE32(X) __builtin_bswap32(X)
+#define UCCONFIG_BE64(X) __builtin_bswap64(X)
+#endif
+
+static inline void ucconfig_mapped_c(char *data,uint16_t address){ *data = UCCONFIG_MAPPED(char,address); }
+static inline void ucconfig_mapped_u8(uint8_t *data,uint16_t address){ *data = UCCONFIG_MAPPED(uint8_t,address); }
+static inline void ucconfig_mapped_8(int8_t *data,uint16_t address){ *data = UCCONFIG_MAPPED(int8_t,address); }
+static inline void ucconfig_mapped_u16(uint16_t *data,uint16_t address){ *data = UCCONFIG_BE16(UCCONFIG_MAPPED(uint16_t,address)); }
+static inline void ucconfig_mapped_16(int16_t *data,uint16_t address){ *data = (int16_t)UCCONFIG_BE16(UCCONFIG_MAPPED(uint16_t,address)); }
+static inline void ucconfig_mapped_u32(uint32_t *data,uint16_t address){ *data = UCCONFIG_BE32(UCCONFIG_MAPPED(uint32_t,address)); }
+static inline void ucconfig_mapped_32(int32_t *data,uint16_t address){ *data = (int32_t)UCCONFIG_BE32(UCCONFIG_MAPPED(uint32_t,address)); }
+
+#ifndef UCCONFIG_NO_FLOAT
+static inline void ucconfig_mapped_float(float *data,uint16_t address){
+
+    //Same conversion as FLASHWRITE_read_float()
+    *data = FLASHWRITE_to_float(UCCONFIG_BE32(UCCONFIG_MAPPED(uint32_t,address)));
+}
+
+static inline void ucconfig_mapped_double(double *data,uint16_t address){
+
+    uint64_t stored = UCCONFIG_BE64(UCCONFIG_MAPPED(uint64_t,address));
+
+    memcpy(data,&stored,8);
+}
+#endif
+#endif
+
+/*!
+    @brief UCCONFIG_decode() converts a variable read with UCCONFIG_read() from the way it is
+    stored in flash to its value, in place.
+    @details Used by the ucconfig_load_all() function in the generated header file. Values are stored
+    in the #FLASHWRITE_FORMAT. The variable may be a member of a packed struct, it is only accessed a byte at a time.
+    @param X The variable to convert, not a pointer to it.
+*/
+#define UCCONFIG_decode(X) _Generic((X),                                   \
+                                    char:      ucconfig_decode_8,       \
+                                    uint8_t:   ucconfig_decode_8,       \
+                                    int8_t:    ucconfig_decode_8,       \
+                                    uint16_t:  ucconfig_decode_16,      \
+                                    int16_t:   ucconfig_decode_16,      \
+                                    uint32_t:  ucconfig_decode_32,      \
+                                    int32_t:   ucconfig_decode_32,      \
+                                    UCCONFIG_DECODE_FLOAT                \
+                                    default:   ucconfig_decode_8        \
+                                                               )((void*)&(X))
+
+#ifndef UCCONFIG_NO_FLOAT
+#define UCCONFIG_DECODE_FLOAT float: ucconfig_decode_float, double: ucconfig_decode_double,
+#else
+#define UCCONFIG_DECODE_FLOAT float: ucconfig_noFloat, double: ucconfig_noFloat,
+#endif
+
+/*!
+    @brief The value of a qM.N fixed point variable times Y, with integer arithmetic only.
+    @details Fixed point variables hold their value times 2^N as an int16_t or int32_t, the generated
+    header defines N as the variable name with _FRAC appended. If Y is an integer the result is
+    an integer, rounded towards minus infinity. If Y is a fixed point value with N fractional bits
+    the result is one too. The product is 64 bits wide so it doesn't overflow before the shift.
+    @param X The stored integer of the variable, eg. from UCCONFIG_get() into an int32_t.
+    @param Y An integer or fixed point value.
+    @param N The number of fractional bits of X.
+*/
+#define UCCONFIG_Q_MUL(X,Y,N) ((int32_t)(((int64_t)(X) * (Y)) >> (N)))
+/*!
+    @brief The integer part of a fixed point value, rounded towards minus infinity.
+*/
+#define UCCONFIG_Q_INT(X,N) ((int32_t)(X) >> (N))
+/*!
+    @brief A fixed point value rounded to the nearest integer.
+*/
+#define UCCONFIG_Q_ROUND(X,N) (((int32_t)(X) + ((N) ? ((int32_t)1 << ((N) - 1)) : 0)) >> (N))
+/*!
+    @brief An integer as a fixed point value with N fractional bits, eg. to compare with a variable.
+*/
+#define UCCONFIG_Q_FROM_INT(X,N) ((int32_t)(X) * ((int32_t)1 << (N)))
+
 /*!
     @brief Set up the module, this should be called before any other module
     function will work.
@@ -206,17 +455,62 @@ void UCCONFIG_setup(
          uint8_t (*flash_read)(uint16_t address),
          void (*flash_write)(uint8_t byte,uint16_t adrress),
          void (*serial_write)(uint8_t byte));
+/*!
+    @brief Same as UCCONFIG_setup() with block flash functions
+    @details Each flash access, eg. a whole uint32_t or a staged page, is one call to the block function
+    instead of one call per byte. Useful for memory with page writes such as I2C EEPROMs. The block
+    functions are also set as the FLASHWRITE block output and input.
+    @param flash_read Pointer to a function which reads length bytes starting at address into data.
+    @param flash_write Pointer to a function which writes length bytes from data starting at address.
+    @param serial_write Pointer to a function which sends a byte over serial communication.
+*/
+void UCCONFIG_setupBlock(
+         void (*flash_read)(uint16_t address,uint8_t *data,uint16_t length),
+         void (*flash_write)(uint16_t address,const uint8_t *data,uint16_t length),
+         void (*serial_write)(uint8_t byte));
 /*!
     @brief Listens to serial communication and sets module in config mode if correct key is sent.
     @details This function should be placed in the output stream of the serial communication. See module example
+    In config mode received bytes are only queued, frames are parsed by UCCONFIG_loop(). This allows
+    the PC to send the next frame while the previous one is being written to flash.
+    The queue is a single producer, single consumer FIFO8, so this can be called from a receive
+    interrupt while UCCONFIG_loop() runs in the main context. Finding the key only flags it, the
+    acknowledge and the switch of outputs happen in the next UCCONFIG_loop() or UCCONFIG_poll().
     @param receivedByte A single byte recieved through serial communication.
  */
 void UCCONFIG_listen(uint8_t receivedByte);
+/*!
+    @brief Same as UCCONFIG_listen() for a buffer of received bytes, eg. a DMA half buffer.
+    @details Bytes before the key are checked one at a time. Once in config mode the rest are queued
+    with a single FIFO8_spscPutn(), bytes which don't fit in the FIFO are dropped as with UCCONFIG_listen().
+    @param data Pointer to the first byte received.
+    @param length The number of bytes received.
+ */
+void UCCONFIG_listen_buffer(const uint8_t *data, size_t length);
 /*!
     @brief Runs config mode if the key has been received.
-    @details This function should be placed in the programs main loop or on a timer callback (see example)
+    @details This function should be placed in the programs main loop or on a timer callback (see example).
+    Queued frames are parsed and executed in order from here.
+
+    Without a clock this blocks until config mode ends, timing out after #UCCONFIG_ACTIVE_MODE_TIMEOUT
+    idle iterations. If a clock was set with UCCONFIG_setClock() this is the same as calling UCCONFIG_poll()
+    with the current time and returns straight away.
  */
 void UCCONFIG_loop(void);
+/*!
+    @brief Parses everything queued and checks the timeouts, then returns.
+    @details A non blocking alternative to UCCONFIG_loop(), call it regularly from the main loop. It returns
+    immediately when config mode isn't active or starting. Config mode ends after #UCCONFIG_TIMEOUT_MS with no
+    received bytes.
+    @param now_ms A millisecond time, only differences between calls are used so it may wrap.
+ */
+void UCCONFIG_poll(uint32_t now_ms);
+/*!
+    @brief Set a millisecond clock for UCCONFIG_loop() (optional)
+    @details With a clock UCCONFIG_loop() calls UCCONFIG_poll() and doesn't block.
+    @param get_ms Pointer to a function returning a millisecond time, eg. a SysTick counter.
+ */
+void UCCONFIG_setClock(uint32_t (*get_ms)(void));
 /*!
     @brief Set the memory address offset of the flash memory pointer (optional)
     @details This module initialises with memory pointer based at position 0. A offset can be supplied to charge the inital position of config parameters in flash.
@@ -238,9 +532,108 @@ void UCCONFIG_setOnExit(void (*on_exit)(void));
 /*!
     @brief Sets the function which is called when the first byte is written to the UC from PC
     @details The function must be of type specified. Use a wrapper to call different function types (see example)
+    When the PC syncs only the changed variables, the rest of memory isn't written again, so this
+    function shouldn't erase it. Bytes which already hold the value written aren't programmed, but
+    this function is still called for them.
     @param on_first The function to be called.
  */
 void UCCONFIG_setOnFirstWrite(void (*on_first)(void));
+/*!
+    @brief Sets the function used to change the serial baud rate (optional)
+    @details Allows the PC to raise the baud rate while in config mode. The default rate is
+    restored when config mode is exited or times out.
+    @param set_baud The function to be called with the new baud rate. It should return 0 if the rate
+    isn't supported. The function must wait for the serial output to finish sending before switching.
+    @param default_baud The baud rate used by the application.
+ */
+void UCCONFIG_setBaud(uint8_t (*set_baud)(uint32_t baud),uint32_t default_baud);
+/*!
+    @brief Sets a block serial write function so each response frame is sent with one call (optional)
+    @details While in config mode, printed frames are collected in a #UCCONFIG_TX_BUFFER_SIZE buffer with
+    STRING11_setBuffer() and sent when the frame ends, eg. as one DMA transfer instead of a call to the
+    serial write function per byte. The application's STRING11 outputs and buffer are restored on exit.
+    @param serial_block Pointer to a function which sends length bytes over the same stream as the serial
+    write function, NULL to send a byte at a time. The bytes must have been sent or copied when it
+    returns, the buffer is reused for the next frame.
+ */
+void UCCONFIG_setSerialBlock(void (*serial_block)(const uint8_t *data,uint16_t length));
+/*!
+    @brief Sets the function used to calculate the CRC of a memory region (optional)
+    @details By default the module calculates a CRC-32 (the same as zlib crc32()) one byte at a
+    time through the flash read function. A hardware CRC unit can be used instead, the function
+    must produce the same CRC-32 for the PC to verify against.
+    @param crc The function to be called, given the start address and the number of bytes.
+ */
+void UCCONFIG_setCrc(uint32_t (*crc)(uint16_t address,uint16_t length));
+/*!
+    @brief Sets a RAM buffer used to stage writes before they go to flash (optional)
+    @details While in config mode writes are collected in the buffer a page at a time, reads of
+    staged pages come from the buffer. Dirty pages are written to flash on terminate, timeout, a
+    #UCCONFIG_COMMIT command, or when a page is needed for a different address. Only the bytes from
+    the first to the last one changed in each page are written, repeated writes to a byte cost nothing.
+    With UCCONFIG_setupBlock() that is a single block write per dirty page.
+    A CRC function set with UCCONFIG_setCrc() reads flash directly, so pages are committed before it runs.
+    @param buffer Pointer to the RAM used for staging, NULL to write straight to flash.
+    @param size The size of the buffer in bytes, up to #UCCONFIG_STAGING_MAX_PAGES pages are used.
+    @param pageSize The size of a flash page, must be a power of 2. Pages start at multiples of this address.
+    @return 1 if the buffer is used, 0 if it holds less than one page or the page size isn't a power of 2.
+ */
+uint8_t UCCONFIG_setStaging(uint8_t *buffer,uint16_t size,uint16_t pageSize);
+/*!
+    @brief Sets the flash geometry so the module erases only the pages a session changes (optional)
+    @details When a staged page is written to flash, the bytes which changed are programmed directly
+    if flash still holds the erased value there. Otherwise the page is erased and the staged copy of
+    the whole page, which holds the bytes the session didn't change, is programmed back. The erased
+    bytes at either end of the page aren't programmed. Each page is erased at most once per session
+    unless it's evicted from the staging buffer, and the on first write function doesn't need to erase.
+    Call after UCCONFIG_setStaging(), which turns the geometry off. With UCCONFIG_setBanks() the banks
+    must start on a page.
+    @param pageSize The size of a flash page, the same as the staging page size.
+    @param erase Function which erases the page starting at the flash address given.
+    @param erasedValue The value of an erased flash byte, eg. 0xFF.
+    @return 1 if the geometry is used, 0 if there is no staging buffer with the same page size or no erase function.
+ */
+uint8_t UCCONFIG_setGeometry(uint16_t pageSize,void (*erase)(uint16_t address),uint8_t erasedValue);
+/*!
+    @brief Keep the config in two banks so a session never changes the one in use (optional)
+    @details Addresses 0 to size - 1 are mapped to the active bank, the one with a valid CRC and the
+    highest version. The first write of a session which changes a byte erases the other bank, copies
+    the active one to it and from then on the session reads and writes there. A terminate writes that bank's footer, which
+    makes it the active bank in one write. A timeout or reset before then leaves the old config in use.
+    A #UCCONFIG_ROLLBACK command makes the other bank active again by clearing the footer marker of the
+    active one, which must be possible without an erase (eg. writing 0x0000 to STM32 flash).
+    UCCONFIG_get() and UCCONFIG_read() are mapped, FLASHWRITE reads made by the application aren't.
+    Call after the setup function and before UCCONFIG_setShadow(). Doesn't work with #UCCONFIG_MEMORY_MAPPED.
+    @param bankA The flash address of the first bank.
+    @param bankB The flash address of the second bank.
+    @param size The number of bytes in each bank, #UCCONFIG_BANK_FOOTER more are used after them.
+    @param erase Function which erases a number of bytes from an address before a bank is written, NULL if not needed.
+    Without one only the parts of the other bank which differ from the active one are copied.
+    @return 1 if either bank holds a valid config, 0 if neither does and bank A is used.
+ */
+uint8_t UCCONFIG_setBanks(uint16_t bankA,uint16_t bankB,uint16_t size,void (*erase)(uint16_t address,uint16_t length));
+/*!
+    @brief Sets a RAM copy of the config region used by UCCONFIG_get() (optional)
+    @details The region is read once here with a single block read, so call it after the setup function.
+    Every flash write made by the module updates the copy, and it is read again when config mode ends in
+    after the on first write function in case it erased flash. Writes are compared with it rather than
+    with flash so unchanged bytes can be skipped. UCCONFIG_get() of an address inside the region is then
+    a memory load, other addresses are still read from flash.
+    @param buffer Pointer to RAM of at least size bytes, NULL to stop using a shadow.
+    @param address The first flash address copied, eg. the address offset.
+    @param size The number of bytes copied.
+ */
+void UCCONFIG_setShadow(uint8_t *buffer,uint16_t address,uint16_t size);
+/*!
+    @brief Read a number of bytes from flash as they are stored
+    @details A single copy from the shadow if the region is inside it, otherwise a single block read.
+    With #UCCONFIG_MEMORY_MAPPED it is always a copy from the memory map.
+    Use UCCONFIG_decode() on each variable read this way, or the generated ucconfig_load_all().
+    @param address The first address to read.
+    @param data Pointer to where the bytes are stored.
+    @param length The number of bytes to read.
+ */
+void UCCONFIG_read(uint16_t address,uint8_t *data,uint16_t length);
 /*!
     @brief Get a character from the given memory address.
     @details This function is utilised in the marco expansion of UCCONFIG_get(). It
@@ -304,6 +697,7 @@ void ucconfig_get_u32(uint32_t *data,uint16_t address);
     @warning Don't call this function manually
 */
 void ucconfig_get_32(int32_t *data,uint16_t address);
+#ifndef UCCONFIG_NO_FLOAT
 /*!
     @brief Get a float from the given memory address.
     @details This function is utilised in the marco expansion of UCCONFIG_get(). It
@@ -313,6 +707,53 @@ void ucconfig_get_32(int32_t *data,uint16_t address);
     @warning Don't call this function manually
 */
 void ucconfig_get_float(float *data,uint16_t address);
+/*!
+    @brief Get a double from the given memory address.
+    @details This function is utilised in the marco expansion of UCCONFIG_get(). It
+    should not be called manually
+    @param data Pointer to a double to store the data in.
+    @param address Address in flash to read the data from.
+    @warning Don't call this function manually
+*/
+void ucconfig_get_double(double *data,uint16_t address);
+#endif
+/*!
+    @brief Convert a 1 byte variable in place, nothing needs to change.
+    @details This function is utilised in the marco expansion of UCCONFIG_decode().
+    @param data Pointer to the variable.
+    @warning Don't call this function manually
+*/
+void ucconfig_decode_8(void *data);
+/*!
+    @brief Convert a stored 16 bit variable in place.
+    @details This function is utilised in the marco expansion of UCCONFIG_decode().
+    @param data Pointer to the variable.
+    @warning Don't call this function manually
+*/
+void ucconfig_decode_16(void *data);
+/*!
+    @brief Convert a stored 32 bit variable in place.
+    @details This function is utilised in the marco expansion of UCCONFIG_decode().
+    @param data Pointer to the variable.
+    @warning Don't call this function manually
+*/
+void ucconfig_decode_32(void *data);
+#ifndef UCCONFIG_NO_FLOAT
+/*!
+    @brief Convert a stored float in place.
+    @details This function is utilised in the marco expansion of UCCONFIG_decode().
+    @param data Pointer to the variable.
+    @warning Don't call this function manually
+*/
+void ucconfig_decode_float(void *data);
+/*!
+    @brief Convert a stored double in place.
+    @details This function is utilised in the marco expansion of UCCONFIG_decode().
+    @param data Pointer to the variable.
+    @warning Don't call this function manually
+*/
+void ucconfig_decode_double(void *data);
+#endif
 
 /**@}*/
 /**@}*/
@@ -0,0 +1,177 @@
+//Host stress test for the single producer, single consumer FIFO8
+//A producer and a consumer thread pass a known sequence through a small buffer so every position wraps
+//many times. Build with make stress, which adds ThreadSanitizer to report any data race on the buffer.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "fifo8.h"
+
+//Small so the positions wrap often and the buffer is regularly full and empty
+#define STRESS_FIFO_SIZE 16
+//Bytes passed through the FIFO by each test
+#define STRESS_BYTES 200000UL
+//Longest span put or popped at once, longer than the buffer so the span calls also get cut short
+#define STRESS_SPAN_MAX 24
+
+//How each side moves bytes
+typedef enum{
+
+    STRESS_SINGLE,      //FIFO8_spscPut() or FIFO8_spscPop()
+    STRESS_SPAN,        //FIFO8_spscPutn() or FIFO8_spscPopn()
+}stress_mode_t;
+
+typedef struct{
+
+    FIFO8_SPSC fifo;
+    stress_mode_t producer;
+    stress_mode_t consumer;
+    unsigned long errors;
+}stress_test_t;
+
+static uint8_t stress_buffer[STRESS_FIFO_SIZE];
+
+//The byte at position i of the sequence, 251 is prime so it never lines up with the buffer size
+static uint8_t stress_byte(unsigned long i){
+
+    return (uint8_t)((i * 7) % 251);
+}
+
+//Span lengths, each thread keeps its own state
+static uint16_t stress_span(uint32_t *state){
+
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+
+    return (uint16_t)(1 + (*state % STRESS_SPAN_MAX));
+}
+
+static void *stress_produce(void *arg){
+
+    stress_test_t *test = arg;
+    uint8_t data[STRESS_SPAN_MAX];
+    uint32_t state = 0x12345678;
+    unsigned long sent = 0;
+
+    while(sent < STRESS_BYTES){
+
+        if(test->producer == STRESS_SINGLE){
+
+            if(FIFO8_spscPut(&test->fifo,stress_byte(sent)) == E_FIFO8_NOERROR){
+                sent++;
+            }
+            else{
+                //Full, let the consumer run on a single core host
+                sched_yield();
+            }
+            continue;
+        }
+
+        uint16_t length = stress_span(&state);
+
+        if(length > STRESS_BYTES - sent){
+            length = (uint16_t)(STRESS_BYTES - sent);
+        }
+
+        for(uint16_t i = 0; i < length; i++){
+            data[i] = stress_byte(sent + i);
+        }
+
+        //Whatever didn't fit is sent again as the start of the next span
+        length = FIFO8_spscPutn(&test->fifo,data,length);
+        sent += length;
+
+        if(length == 0){
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+static void *stress_consume(void *arg){
+
+    stress_test_t *test = arg;
+    uint8_t data[STRESS_SPAN_MAX];
+    uint32_t state = 0x9ABCDEF0;
+    unsigned long received = 0;
+
+    while(received < STRESS_BYTES){
+
+        //The producer can only make it grow, it never holds more than the buffer size minus one
+        if(FIFO8_spscSize(&test->fifo) >= STRESS_FIFO_SIZE){
+            test->errors++;
+        }
+
+        uint16_t length = 1;
+
+        if(test->consumer == STRESS_SINGLE){
+
+            if(FIFO8_spscPop(&test->fifo,data) != E_FIFO8_NOERROR){
+                //Empty, let the producer run on a single core host
+                sched_yield();
+                continue;
+            }
+        }
+        else{
+
+            length = FIFO8_spscPopn(&test->fifo,data,stress_span(&state));
+
+            if(length == 0){
+                sched_yield();
+            }
+        }
+
+        for(uint16_t i = 0; i < length; i++){
+
+            if(data[i] != stress_byte(received + i)){
+                test->errors++;
+            }
+        }
+
+        received += length;
+    }
+
+    return NULL;
+}
+
+//Run one producer and consumer pair, returns the number of errors
+static unsigned long stress_run(const char *name, stress_mode_t producer, stress_mode_t consumer){
+
+    stress_test_t test;
+    pthread_t threads[2];
+    uint8_t byte;
+
+    FIFO8_spscInit(&test.fifo,stress_buffer,STRESS_FIFO_SIZE);
+    test.producer = producer;
+    test.consumer = consumer;
+    test.errors = 0;
+
+    pthread_create(&threads[0],NULL,stress_produce,&test);
+    pthread_create(&threads[1],NULL,stress_consume,&test);
+    pthread_join(threads[0],NULL);
+    pthread_join(threads[1],NULL);
+
+    //Everything sent was taken, so nothing is left over
+    if(FIFO8_spscPop(&test.fifo,&byte) != E_FIFO8_EMPTY){
+        test.errors++;
+    }
+
+    printf("%-12s %lu bytes, %lu errors\n",name,STRESS_BYTES,test.errors);
+    return test.errors;
+}
+
+int main(void){
+
+    unsigned long errors = 0;
+
+    errors += stress_run("put/pop",STRESS_SINGLE,STRESS_SINGLE);
+    errors += stress_run("putn/popn",STRESS_SPAN,STRESS_SPAN);
+    errors += stress_run("put/popn",STRESS_SINGLE,STRESS_SPAN);
+    errors += stress_run("putn/pop",STRESS_SPAN,STRESS_SINGLE);
+
+    return (errors == 0) ? 0 : 1;
+}
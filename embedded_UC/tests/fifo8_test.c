@@ -0,0 +1,141 @@
+//Host test for the FIFO8 span calls
+//FIFO8_putn() and FIFO8_popn() are run from every start position of a small buffer so each wraps
+//around the end, then checked against the idle flag used by FIFO8_flush() and AUTO mode.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "fifo8.h"
+
+#define TEST_FIFO_SIZE 8
+
+//Print the failed check and count it
+#define TEST_CHECK(x)                                                   \
+    do{                                                                 \
+        if(!(x)){                                                       \
+            printf("%s:%d: check failed: %s\n",__FILE__,__LINE__,#x);   \
+            test_errors++;                                              \
+        }                                                               \
+    }while(0)
+
+static unsigned long test_errors;
+
+static uint8_t test_buffer[TEST_FIFO_SIZE];
+
+//Bytes passed to the output function
+static uint8_t test_out[64];
+static uint8_t test_outLength;
+
+static void test_output(uint8_t byte){
+
+    test_out[test_outLength++] = byte;
+}
+
+//Move the head and tail to position, leaving the FIFO8 empty
+static void test_start(FIFO8 *fifo, fifo8_mode_t mode, uint16_t position){
+
+    FIFO8_init(fifo,mode,test_buffer,TEST_FIFO_SIZE,&test_output);
+
+    for(uint16_t i = 0; i < position; i++){
+
+        FIFO8_put(fifo,0xEE);
+        FIFO8_pop(fifo);
+    }
+}
+
+//Every span length from every start position, so every split of the two memcpy calls is used
+static void test_wrap(void){
+
+    FIFO8 fifo;
+    uint8_t data[TEST_FIFO_SIZE];
+    uint8_t taken[TEST_FIFO_SIZE];
+
+    for(uint16_t position = 0; position < TEST_FIFO_SIZE; position++){
+
+        for(uint16_t length = 0; length < TEST_FIFO_SIZE; length++){
+
+            test_start(&fifo,FIFO8_TRIGGER,position);
+
+            for(uint16_t i = 0; i < length; i++){
+                data[i] = (uint8_t)(position * 16 + i);
+            }
+
+            TEST_CHECK(FIFO8_putn(&fifo,data,length) == length);
+            TEST_CHECK(FIFO8_size(&fifo) == length);
+
+            memset(taken,0,sizeof(taken));
+            TEST_CHECK(FIFO8_popn(&fifo,taken,TEST_FIFO_SIZE) == length);
+            TEST_CHECK(memcmp(data,taken,length) == 0);
+            TEST_CHECK(FIFO8_size(&fifo) == 0);
+            TEST_CHECK(fifo.idle == 1);
+        }
+    }
+}
+
+//Spans longer than the space or the content are cut short, single bytes and spans mix
+static void test_limits(void){
+
+    FIFO8 fifo;
+    uint8_t data[TEST_FIFO_SIZE + 4] = {1,2,3,4,5,6,7,8,9,10,11,12};
+    uint8_t taken[TEST_FIFO_SIZE + 4];
+
+    //One position is always left empty
+    test_start(&fifo,FIFO8_TRIGGER,5);
+    TEST_CHECK(FIFO8_putn(&fifo,data,sizeof(data)) == TEST_FIFO_SIZE - 1);
+    TEST_CHECK(FIFO8_put(&fifo,99) == E_FIFO8_FULL);
+    TEST_CHECK(FIFO8_putn(&fifo,data,1) == 0);
+
+    //A partial span leaves the rest in order for FIFO8_pop()
+    TEST_CHECK(FIFO8_popn(&fifo,taken,3) == 3);
+    TEST_CHECK((taken[0] == 1) && (taken[1] == 2) && (taken[2] == 3));
+    TEST_CHECK(fifo.idle == 0);
+    TEST_CHECK(FIFO8_pop(&fifo) == 4);
+
+    //More than is held only takes what is there
+    TEST_CHECK(FIFO8_popn(&fifo,taken,sizeof(taken)) == 3);
+    TEST_CHECK((taken[0] == 5) && (taken[1] == 6) && (taken[2] == 7));
+    TEST_CHECK(fifo.idle == 1);
+
+    TEST_CHECK(FIFO8_popn(&fifo,taken,sizeof(taken)) == 0);
+    TEST_CHECK(fifo.idle == 1);
+}
+
+//A FIFO8 emptied by FIFO8_popn() is idle, so flushing stops and AUTO mode starts again
+static void test_idle(void){
+
+    FIFO8 fifo;
+    const uint8_t data[4] = {'a','b','c','d'};
+    uint8_t taken[4];
+
+    //The first put starts the output, the rest wait for the output to call FIFO8_get()
+    test_start(&fifo,FIFO8_AUTO,6);
+    test_outLength = 0;
+    TEST_CHECK(FIFO8_putn(&fifo,data,2) == 2);
+    TEST_CHECK((test_outLength == 1) && (test_out[0] == 'a'));
+
+    //Taking the rest stops the output, the next span has to start it again
+    TEST_CHECK(FIFO8_popn(&fifo,taken,sizeof(taken)) == 1);
+    TEST_CHECK(taken[0] == 'b');
+    TEST_CHECK(FIFO8_putn(&fifo,&data[2],2) == 2);
+    TEST_CHECK((test_outLength == 2) && (test_out[1] == 'c'));
+
+    //Flush outputs whatever FIFO8_popn() left and returns once empty
+    test_start(&fifo,FIFO8_TRIGGER,7);
+    test_outLength = 0;
+    FIFO8_putn(&fifo,data,4);
+    TEST_CHECK(FIFO8_popn(&fifo,taken,1) == 1);
+    FIFO8_flush(&fifo);
+    TEST_CHECK((test_outLength == 3) && (memcmp(test_out,&data[1],3) == 0));
+    TEST_CHECK(fifo.idle == 1);
+}
+
+int main(void){
+
+    test_wrap();
+    test_limits();
+    test_idle();
+
+    printf("fifo8_test %lu errors\n",test_errors);
+    return (test_errors == 0) ? 0 : 1;
+}
@@ -0,0 +1,302 @@
+//Host test for flashLog on two RAM backed flash pages
+//The flash only programs erased bytes, so anything written twice without an erase is reported. A reset
+//is simulated by cutting the power part way through programming, then calling FLASHLOG_init() again.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "flashLog.h"
+
+#define TEST_PAGE_A 0x0800
+#define TEST_PAGE_B 0x0C00
+#define TEST_PAGE_SIZE 256
+#define TEST_IMAGE_SIZE 40
+
+//Print the failed check and count it
+#define TEST_CHECK(x)                                                   \
+    do{                                                                 \
+        if(!(x)){                                                       \
+            printf("%s:%d: unit %u check failed: %s\n",__FILE__,__LINE__,test_unit,#x); \
+            test_errors++;                                              \
+        }                                                               \
+    }while(0)
+
+static unsigned long test_errors;
+
+static uint8_t test_flash[2][TEST_PAGE_SIZE];
+static uint8_t test_unit;
+
+//Bytes which can still be programmed before the power is cut
+static uint32_t test_budget;
+//Cut the power when a page header is programmed, the last step of a compaction
+static uint8_t test_cutHeader;
+//Bytes programmed which weren't erased, or programs not aligned to the program size
+static unsigned long test_flashErrors;
+
+static uint8_t test_image[TEST_IMAGE_SIZE];
+//What the image should hold
+static uint8_t test_expect[TEST_IMAGE_SIZE];
+
+static uint8_t *test_at(uint32_t address){
+
+    if((address >= TEST_PAGE_A) && (address < TEST_PAGE_A + TEST_PAGE_SIZE)){
+        return &test_flash[0][address - TEST_PAGE_A];
+    }
+    if((address >= TEST_PAGE_B) && (address < TEST_PAGE_B + TEST_PAGE_SIZE)){
+        return &test_flash[1][address - TEST_PAGE_B];
+    }
+
+    test_flashErrors++;
+    return NULL;
+}
+
+static void test_read(uint32_t address,uint8_t *data,uint16_t length){
+
+    for(uint16_t i = 0; i < length; i++){
+
+        uint8_t *byte = test_at(address + i);
+        data[i] = (byte != NULL) ? *byte : 0;
+    }
+}
+
+static void test_program(uint32_t address,const uint8_t *data,uint16_t length){
+
+    if(((address % test_unit) != 0) || ((length % test_unit) != 0)){
+        test_flashErrors++;
+    }
+
+    if(test_cutHeader && ((address == TEST_PAGE_A) || (address == TEST_PAGE_B))){
+        test_budget = 0;
+    }
+
+    for(uint16_t i = 0; (i < length) && (test_budget > 0); i++){
+
+        uint8_t *byte = test_at(address + i);
+
+        if(byte == NULL){
+            continue;
+        }
+        if(*byte != FLASHLOG_ERASED){
+            test_flashErrors++;
+        }
+
+        *byte = data[i];
+        test_budget--;
+    }
+}
+
+static void test_erase(uint32_t address){
+
+    uint8_t *page = test_at(address);
+
+    if((page != NULL) && (test_budget > 0)){
+        memset(page,FLASHLOG_ERASED,TEST_PAGE_SIZE);
+    }
+}
+
+//Power back on and rebuild the image from flash, then check it
+static void test_reset(void){
+
+    test_budget = UINT32_MAX;
+    test_cutHeader = 0;
+
+    TEST_CHECK(FLASHLOG_init(TEST_PAGE_A,TEST_PAGE_B,TEST_PAGE_SIZE,test_unit,test_image,TEST_IMAGE_SIZE) == E_FLASHLOG_NOERROR);
+    TEST_CHECK(memcmp(test_image,test_expect,TEST_IMAGE_SIZE) == 0);
+}
+
+//Blank flash and a fresh store
+static void test_start(void){
+
+    memset(test_flash,FLASHLOG_ERASED,sizeof(test_flash));
+    memset(test_expect,FLASHLOG_ERASED,sizeof(test_expect));
+    test_flashErrors = 0;
+    test_reset();
+    TEST_CHECK(FLASHLOG_free() == 0);
+}
+
+static void test_write(uint16_t address,const char *text){
+
+    uint16_t length = (uint16_t)strlen(text);
+
+    FLASHLOG_write(address,(const uint8_t *)text,length);
+    memcpy(&test_expect[address],text,length);
+}
+
+//Bytes used by a record, as laid out by flashLog.c
+static uint16_t test_recordSize(uint8_t length){
+
+    return (uint16_t)(((4 + length + test_unit - 1) & ~(test_unit - 1)) + test_unit);
+}
+
+//Appended records, records split at FLASHLOG_RECORD_DATA and repeated compactions all replay
+static void test_replay(void){
+
+    uint8_t data[TEST_IMAGE_SIZE];
+    uint16_t free;
+
+    test_start();
+
+    test_write(0,"abcd");
+    test_write(2,"0123456789012345678901234567890123456");
+    test_write(39,"z");
+    TEST_CHECK(FLASHLOG_free() > 0);
+
+    FLASHLOG_read(0,data,TEST_IMAGE_SIZE);
+    TEST_CHECK(memcmp(data,test_expect,TEST_IMAGE_SIZE) == 0);
+
+    //Writing the same values appends nothing
+    free = FLASHLOG_free();
+    test_write(4,"2345");
+    TEST_CHECK(FLASHLOG_free() == free);
+
+    test_reset();
+    TEST_CHECK(FLASHLOG_free() == free);
+
+    //Enough writes for many compactions, resetting now and again
+    for(uint16_t i = 0; i < 400; i++){
+
+        char text[4] = {(char)('a' + i % 26),(char)('A' + i % 7),(char)('0' + i % 10),0};
+
+        test_write((uint16_t)((i * 7) % (TEST_IMAGE_SIZE - 3)),text);
+
+        if((i % 37) == 0){
+            test_reset();
+        }
+    }
+
+    test_reset();
+    TEST_CHECK(test_flashErrors == 0);
+}
+
+//A record whose commit unit wasn't programmed is skipped, and the next one goes after it
+static void test_tornRecord(void){
+
+    uint16_t free;
+
+    test_start();
+    test_write(0,"first");
+    test_write(10,"xy");
+    free = FLASHLOG_free();
+
+    //Everything but the commit unit
+    test_budget = test_recordSize(2) - test_unit;
+    FLASHLOG_write(20,(const uint8_t *)"zz",2);
+
+    test_reset();
+    TEST_CHECK(FLASHLOG_free() == free - test_recordSize(2));
+
+    test_write(30,"after");
+    test_reset();
+    TEST_CHECK(test_flashErrors == 0);
+}
+
+//A record cut off before its length byte can't be stepped over, the next write compacts
+static void test_tornLength(void){
+
+    uint8_t header[2];
+
+    test_start();
+    test_write(0,"first");
+    test_write(10,"xy");
+
+    //Only the address
+    test_budget = 2;
+    FLASHLOG_write(20,(const uint8_t *)"zz",2);
+
+    test_reset();
+    TEST_CHECK(FLASHLOG_free() == 0);
+
+    //Page A held the records, the compaction moves them to page B
+    test_write(30,"after");
+    test_read(TEST_PAGE_B,header,2);
+    TEST_CHECK((header[0] != FLASHLOG_ERASED) && (header[1] != FLASHLOG_ERASED));
+
+    test_reset();
+    TEST_CHECK(FLASHLOG_free() > 0);
+    TEST_CHECK(test_flashErrors == 0);
+}
+
+//A reset after the compaction records but before its page header leaves the old page active
+static void test_tornCompaction(void){
+
+    test_start();
+    test_write(0,"first");
+    test_write(10,"xy");
+
+    test_cutHeader = 1;
+    FLASHLOG_compact();
+    //The records after the page header were programmed, the header wasn't
+    TEST_CHECK(test_flash[1][(test_unit > 4) ? test_unit : 4] != FLASHLOG_ERASED);
+    TEST_CHECK(test_flash[1][0] == FLASHLOG_ERASED);
+
+    test_reset();
+    TEST_CHECK(FLASHLOG_free() > 0);
+
+    //Still appending to page A, the next compaction erases page B again
+    test_write(20,"more");
+    FLASHLOG_compact();
+    test_write(30,"last");
+
+    test_reset();
+    TEST_CHECK(test_flashErrors == 0);
+
+    //A reset at any point of a compaction loses nothing
+    for(uint32_t budget = 0; budget < TEST_PAGE_SIZE; budget++){
+
+        test_start();
+        test_write(0,"first");
+        test_write(10,"xy");
+
+        test_budget = budget;
+        FLASHLOG_compact();
+        test_reset();
+
+        test_write(20,"more");
+        test_reset();
+        TEST_CHECK(test_flashErrors == 0);
+    }
+}
+
+//The page with the newer sequence number is active when the 16 bit number wraps
+static void test_sequenceWrap(void){
+
+    test_start();
+    test_write(0,"first");
+
+    //As if page A had been compacted into 65535 times
+    test_flash[0][2] = 0xFF;
+    test_flash[0][3] = 0xFF;
+    test_reset();
+
+    //Compacts into page B as sequence 0, then a record only page B holds
+    test_write(10,"wrap");
+    FLASHLOG_compact();
+    TEST_CHECK((test_flash[1][2] == 0) && (test_flash[1][3] == 0));
+    test_write(20,"b");
+    test_reset();
+
+    //And back into page A as sequence 1
+    FLASHLOG_compact();
+    TEST_CHECK((test_flash[0][2] == 0) && (test_flash[0][3] == 1));
+    test_write(30,"a");
+    test_reset();
+    TEST_CHECK(test_flashErrors == 0);
+}
+
+int main(void){
+
+    FLASHLOG_setup(&test_read,&test_program,&test_erase);
+
+    for(test_unit = 1; test_unit <= 8; test_unit *= 2){
+
+        test_replay();
+        test_tornRecord();
+        test_tornLength();
+        test_tornCompaction();
+        test_sequenceWrap();
+    }
+
+    printf("flashLog_test %lu errors\n",test_errors);
+    return (test_errors == 0) ? 0 : 1;
+}
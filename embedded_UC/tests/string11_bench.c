@@ -0,0 +1,275 @@
+//Host check and benchmark of the STRING11 integer formatting
+//The digit pair table versions are compared against the divide per digit versions they replaced, for
+//every 8 and 16 bit value, each digit count edge and random 32 bit values, then both are timed.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "string11.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_UNIT "cycles"
+#endif
+
+//Random 32 bit values checked against the old versions
+#define BENCH_RANDOM 2000000UL
+//Values formatted by each timed run and how many runs are made
+#define BENCH_VALUES 65536
+#define BENCH_REPEAT 50
+
+//Output of the old and current versions, each is reset before a value is printed
+static char bench_old[16];
+static uint8_t bench_oldLength;
+static char bench_new[16];
+static uint8_t bench_newLength;
+
+static void bench_oldOut(uint8_t byte){
+
+    bench_old[bench_oldLength++] = (char)byte;
+}
+
+static void bench_newOut(uint8_t byte){
+
+    bench_new[bench_newLength++] = (char)byte;
+}
+
+//The versions before the digit pair table, unchanged apart from the name and output
+static void old_print_u8(uint8_t x){
+
+    if(x < 10){
+
+        bench_oldOut(x+48);
+        return;
+    }
+    if(x < 100){
+
+        bench_oldOut((uint8_t)(x/10) + 48);
+        bench_oldOut(x%10 + 48);
+        return;
+    }
+    else{
+
+        bench_oldOut((uint8_t)(x/100) + 48);
+        x = x%100;
+        bench_oldOut((uint8_t)(x/10) + 48);
+        bench_oldOut(x%10 + 48);
+        return;
+    }
+}
+
+static void old_print_u16(uint16_t x){
+
+    uint16_t top = 10000;
+    uint16_t mod;
+    uint8_t printed = 0;
+
+    if(x == 0){
+
+        bench_oldOut((char)'0');
+        return;
+    }
+
+    while(top){
+
+        mod = x/top;
+        if(mod || printed){
+            bench_oldOut((uint8_t)(mod+48));
+            printed = 1;
+        }
+        x = x % top;
+        top /= 10;
+    }
+    return;
+}
+
+static void old_print_u32(uint32_t x){
+
+    uint32_t top = 1000000000;
+    uint32_t mod;
+    uint8_t printed = 0;
+
+    if(x == 0){
+
+        bench_oldOut((char)'0');
+            printed = 1;
+        return;
+    }
+
+    while(top){
+
+        mod = x/top;
+        if(mod || printed){
+            bench_oldOut((uint8_t)(mod+48));
+            printed = 1;
+        }
+        x = x % top;
+        top /= 10;
+    }
+    return;
+}
+
+static uint32_t bench_state = 1;
+
+//Shifted by a random amount so every digit count is about as likely
+static uint32_t bench_random(void){
+
+    uint32_t shift;
+
+    bench_state ^= bench_state << 13;
+    bench_state ^= bench_state >> 17;
+    bench_state ^= bench_state << 5;
+    shift = bench_state % 32;
+
+    bench_state ^= bench_state << 13;
+    bench_state ^= bench_state >> 17;
+    bench_state ^= bench_state << 5;
+
+    return bench_state >> shift;
+}
+
+//Returns 1 if the two outputs differ, and prints the value that failed
+static unsigned long bench_compare(const char *name, uint32_t x){
+
+    if((bench_oldLength == bench_newLength) && (memcmp(bench_old,bench_new,bench_oldLength) == 0)){
+        return 0;
+    }
+
+    printf("%s %lu: old %.*s new %.*s\n",name,(unsigned long)x,bench_oldLength,bench_old,
+            bench_newLength,bench_new);
+    return 1;
+}
+
+//Check print_u32() and u32toa() against the old print_u32() for one value
+static unsigned long bench_check32(uint32_t x){
+
+    char buffer[11];
+    uint8_t length;
+    unsigned long errors;
+
+    bench_oldLength = 0;
+    bench_newLength = 0;
+    old_print_u32(x);
+    print_u32(x);
+    errors = bench_compare("print_u32",x);
+
+    length = u32toa(x,buffer);
+    bench_newLength = length;
+    memcpy(bench_new,buffer,length);
+    errors += bench_compare("u32toa",x);
+
+    //u32toa() also terminates the string
+    if(buffer[length] != '\0'){
+        printf("u32toa %lu: not terminated\n",(unsigned long)x);
+        errors++;
+    }
+
+    return errors;
+}
+
+static unsigned long bench_check(void){
+
+    unsigned long errors = 0;
+    uint32_t x;
+
+    for(x = 0; x <= UINT8_MAX; x++){
+
+        bench_oldLength = 0;
+        bench_newLength = 0;
+        old_print_u8((uint8_t)x);
+        print_u8((uint8_t)x);
+        errors += bench_compare("print_u8",x);
+    }
+
+    for(x = 0; x <= UINT16_MAX; x++){
+
+        bench_oldLength = 0;
+        bench_newLength = 0;
+        old_print_u16((uint16_t)x);
+        print_u16((uint16_t)x);
+        errors += bench_compare("print_u16",x);
+    }
+
+    //Either side of every change in the number of digits
+    errors += bench_check32(0);
+    for(x = 10; x <= 1000000000; x *= 10){
+
+        errors += bench_check32(x - 1);
+        errors += bench_check32(x);
+    }
+    errors += bench_check32(UINT32_MAX);
+
+    for(unsigned long i = 0; i < BENCH_RANDOM; i++){
+
+        errors += bench_check32(bench_random());
+    }
+
+    return errors;
+}
+
+//A timestamp in cycles where the host has a counter, otherwise in nanoseconds
+static uint64_t bench_time(void){
+
+#ifdef BENCH_UNIT
+    return __rdtsc();
+#else
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC,&now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+#endif
+}
+
+#ifndef BENCH_UNIT
+#define BENCH_UNIT "ns"
+#endif
+
+static uint32_t bench_values[BENCH_VALUES];
+//Keeps u32toa() from being optimised out
+static volatile uint8_t bench_length;
+
+//Time one formatting call over every value, result is set to the time per conversion
+#define BENCH_RUN(result, call, reset)                                  \
+    do{                                                                 \
+        uint64_t start = bench_time();                                  \
+        for(int r = 0; r < BENCH_REPEAT; r++){                          \
+            for(int i = 0; i < BENCH_VALUES; i++){                      \
+                reset = 0;                                              \
+                call;                                                   \
+            }                                                           \
+        }                                                               \
+        result = (double)(bench_time() - start) / ((double)BENCH_REPEAT * BENCH_VALUES); \
+    }while(0)
+
+int main(void){
+
+    unsigned long errors;
+    char buffer[11];
+    double old32, new32, toa, old16, new16;
+
+    STRING11_setOutput(&bench_newOut);
+
+    errors = bench_check();
+    printf("%lu mismatches\n",errors);
+
+    for(int i = 0; i < BENCH_VALUES; i++){
+        bench_values[i] = bench_random();
+    }
+
+    //The first run also warms the caches
+    for(int run = 0; run < 3; run++){
+
+        BENCH_RUN(old32,old_print_u32(bench_values[i]),bench_oldLength);
+        BENCH_RUN(new32,print_u32(bench_values[i]),bench_newLength);
+        BENCH_RUN(toa,bench_length = u32toa(bench_values[i],buffer),bench_newLength);
+        BENCH_RUN(old16,old_print_u16((uint16_t)bench_values[i]),bench_oldLength);
+        BENCH_RUN(new16,print_u16((uint16_t)bench_values[i]),bench_newLength);
+
+        printf("%s per conversion: print_u32 old %.1f new %.1f u32toa %.1f, print_u16 old %.1f new %.1f\n",
+                BENCH_UNIT,old32,new32,toa,old16,new16);
+    }
+
+    return (errors == 0) ? 0 : 1;
+}
@@ -1,5 +1,7 @@
 import numpy as np
 import random
+import struct
+import sys
 import logging
 import datetime
 import yaml
@@ -10,8 +12,10 @@ __version__ = '0.1.0-alpha'
     #Variable types
 ##########################
 
-#Float is limited by signed 32 bit integer size divied by 100
-#as this is how it is currently stored in EEPROM memory
+#qM.N types are fixed point, stored as the signed integer cType holding the value times 2^N.
+#M counts the sign bit, so M + N is the size in bits. The UC needs no float support for them.
+#Float limits are for IEEE single precision storage, a UC which stores floats as a
+#signed 32 bit integer scaled by 10^4 is limited to scaledFloatMax, see getLimits()
 types = [
         {'name':'uint8_t',
             'size': 1,
@@ -39,22 +43,94 @@ types = [
             'max': 2**31 -1},
         {'name':'float',
             'size': 4,
-            'min': (-2**31 + 1) / 10000,
-            'max': (2**31 - 1) / 10000},
+            'min': -3.4028234663852886e+38,
+            'max': 3.4028234663852886e+38},
+        {'name':'double',
+            'size': 8,
+            'min': -sys.float_info.max,
+            'max': sys.float_info.max},
         {'name':'char',
             'size': 1,
             'min': 32,
-            'max': 127}
+            'max': 127},
+        {'name':'q1.15',
+            'size': 2,
+            'min': -(2**15 - 1) / 2**15,
+            'max': (2**15 - 1) / 2**15,
+            'frac': 15,
+            'cType': 'int16_t'},
+        {'name':'q8.8',
+            'size': 2,
+            'min': -(2**15 - 1) / 2**8,
+            'max': (2**15 - 1) / 2**8,
+            'frac': 8,
+            'cType': 'int16_t'},
+        {'name':'q1.31',
+            'size': 4,
+            'min': -(2**31 - 1) / 2**31,
+            'max': (2**31 - 1) / 2**31,
+            'frac': 31,
+            'cType': 'int32_t'},
+        {'name':'q16.16',
+            'size': 4,
+            'min': -(2**31 - 1) / 2**16,
+            'max': (2**31 - 1) / 2**16,
+            'frac': 16,
+            'cType': 'int32_t'}
         ]
 
+#Largest float a UC without IEEE float storage can hold
+scaledFloatMax = (2**31 - 1) / 10000
+
+#struct format characters of the types stored as their IEEE-754 bits
+ieeeCodes = {'float':'f','double':'d'}
+
 class Header():
 
 
     def __init__(self,config):
 
+        #Byte order of multi byte values in the UC memory, set from the UC's storage format
+        self.byteOrder = 'big'
+        #Floats are stored 'scaled' by 10^4 or as their 'ieee' bits, doubles always as their bits
+        self.floatFormat = 'scaled'
         return
 
 
+    #Limits of the values the UC can store for a type, a float's depend on floatFormat
+    def getLimits(self,dataType):
+
+        listIndex = self.getTypeIndex(dataType)
+
+        if listIndex == None:
+            return None
+
+        if dataType == 'float' and self.floatFormat == 'scaled':
+            return -scaledFloatMax,scaledFloatMax
+
+        return types[listIndex]['min'],types[listIndex]['max']
+
+    #Check every value fits the UC's storage format, only known once connected
+    def checkStorage(self,dataList):
+
+        for data in dataList:
+
+            limits = self.getLimits(data['dataType'])
+
+            if limits == None:
+                return False
+
+            if data['value'] < limits[0] or data['value'] > limits[1]:
+                logging.warning('Variable {} value {} out of range for type {} as the UC stores it, minimum: {}, maximum: {}'.format(
+                            data['name'],
+                            data['value'],
+                            data['dataType'],
+                            limits[0],
+                            limits[1]))
+                return False
+
+        return True
+
     def checkLimits(self,data,dataType):
 
         listIndex = self.getTypeIndex(dataType)
@@ -94,13 +170,14 @@ class Header():
                 continue
 
             dataValue = self.generateRandomValue(types[ranTypeIndex]['name'])
+            limits = self.getLimits(types[ranTypeIndex]['name'])
             dataList.append({
                 'name':'random_variable_{}'.format(dataNumber),
                 'desc':'A randomly generated variable',
                 'dataType':types[ranTypeIndex]['name'],
                 'value':dataValue,
-                'min':types[ranTypeIndex]['min'],
-                'max':types[ranTypeIndex]['max'],
+                'min':limits[0],
+                'max':limits[1],
                 'size':types[ranTypeIndex]['size']})
             dataNumber = dataNumber + 1
 
@@ -120,6 +197,161 @@ class Header():
 
         return listIndex
 
+    #Return the memory address of each variable, variables are packed back to back
+    #unless alignLayout() has given them an address
+    def getLayout(self,dataList):
+
+        layout = []
+        currentMemoryPosition = 0
+
+        for data in dataList:
+            layout.append(data.get('address',currentMemoryPosition))
+            currentMemoryPosition = layout[-1] + data['size']
+
+        return layout
+
+    #Give each variable an address on a multiple of its size, stored in data['address']
+    #Variables are placed largest first so as little padding as possible is needed
+    #Returns the number of padding bytes
+    def alignLayout(self,dataList):
+
+        currentMemoryPosition = 0
+        padding = 0
+
+        for data in sorted(dataList,key=lambda d: d['size'],reverse=True):
+
+            address = -(-currentMemoryPosition // data['size']) * data['size']
+            padding = padding + address - currentMemoryPosition
+            data['address'] = address
+            currentMemoryPosition = address + data['size']
+
+        logging.info('Aligned layout uses {} bytes with {} bytes of padding'.format(currentMemoryPosition,padding))
+        return padding
+
+    #Number of bytes from address zero to the end of the last variable
+    def getImageSize(self,dataList):
+
+        return max([address + data['size'] for data,address in zip(dataList,self.getLayout(dataList))],default=0)
+
+    #Convert the raw bytes of a variable as stored in the UC memory to its value
+    #Values are stored in byteOrder, floats as a signed integer scaled by 10^4 unless floatFormat is 'ieee'
+    def decodeValue(self,raw,dataType):
+
+        listIndex = self.getTypeIndex(dataType)
+        if listIndex == None:
+            return None
+
+        if len(raw) != types[listIndex]['size']:
+            logging.warning('Expected {} bytes for type {}, got {}'.format(types[listIndex]['size'],dataType,len(raw)))
+            return None
+
+        if dataType == 'char':
+            return chr(raw[0])
+
+        if self.isIeee(dataType):
+            return struct.unpack(self.ieeeFormat(dataType),raw)[0]
+
+        if dataType == 'float':
+            return int.from_bytes(raw,self.byteOrder,signed=True) / 10000
+
+        if self.isFixed(dataType):
+            return int.from_bytes(raw,self.byteOrder,signed=True) / 2**types[listIndex]['frac']
+
+        return int.from_bytes(raw,self.byteOrder,signed=(dataType[0] != 'u'))
+
+    #Convert a variable value to the raw bytes the UC stores for it
+    #Scaled floats follow the UC's own single precision parsing of the sent string and
+    #scaling by 10^4, so the result matches the UC memory byte for byte
+    def encodeValue(self,value,dataType):
+
+        listIndex = self.getTypeIndex(dataType)
+        if listIndex == None:
+            return None
+
+        size = types[listIndex]['size']
+
+        if dataType == 'char':
+            return bytes([value])
+
+        if self.isIeee(dataType):
+            return struct.pack(self.ieeeFormat(dataType),value)
+
+        if dataType == 'float':
+            number = np.float32(0)
+            digits = 0
+            point = None
+            text = self.formatScaled(value)
+
+            for character in text.lstrip('-'):
+                if character == '.':
+                    point = digits
+                    continue
+                number = np.float32(number * np.float32(10))
+                number = np.float32(number + np.float32(ord(character) - 48))
+                digits = digits + 1
+
+            if text[0] == '-':
+                number = -number
+
+            if point != None:
+                for j in range(digits - point):
+                    number = np.float32(number / np.float32(10))
+
+            for j in range(4):
+                number = np.float32(number * np.float32(10))
+
+            return int(number).to_bytes(size,self.byteOrder,signed=True)
+
+        #Rounded to the nearest step of 2^-N
+        if self.isFixed(dataType):
+            return int(round(value * 2**types[listIndex]['frac'])).to_bytes(size,self.byteOrder,signed=True)
+
+        return int(value).to_bytes(size,self.byteOrder,signed=(dataType[0] != 'u'))
+
+    #The string a scaled float is sent as, the UC only parses digits, a sign and a decimal point
+    #str() gives scientific notation for small magnitudes, eg. 1e-05, so those are written out in full
+    def formatScaled(self,value):
+
+        text = str(value)
+
+        if 'e' in text:
+            mantissa,exponent = text.split('e')
+            text = '{:.{}f}'.format(value,max(len(mantissa.partition('.')[2]) - int(exponent),0))
+
+        return text
+
+    #True if the type is stored as its IEEE-754 bits
+    def isIeee(self,dataType):
+
+        return dataType == 'double' or (dataType == 'float' and self.floatFormat == 'ieee')
+
+    #True if the type is a qM.N fixed point type
+    def isFixed(self,dataType):
+
+        listIndex = self.getTypeIndex(dataType)
+        return listIndex != None and 'frac' in types[listIndex]
+
+    #The C type a variable is declared as, the stored integer for fixed point types
+    def getCType(self,dataType):
+
+        listIndex = self.getTypeIndex(dataType)
+        return types[listIndex].get('cType',dataType)
+
+    #struct format of an IEEE type in the UC byte order
+    def ieeeFormat(self,dataType):
+
+        return ('>' if self.byteOrder == 'big' else '<') + ieeeCodes[dataType]
+
+    #Build the memory image of the whole variable list as stored on the UC
+    def makeImage(self,dataList):
+
+        image = bytearray(self.getImageSize(dataList))
+
+        for data,address in zip(dataList,self.getLayout(dataList)):
+            image[address:address + data['size']] = self.encodeValue(data['value'],data['dataType'])
+
+        return bytes(image)
+
     def generateRandomValue(self,dataType):
 
         data = None
@@ -128,12 +360,20 @@ class Header():
         if listIndex == None:
             return None
 
-        if dataType != 'float':
+        limits = self.getLimits(dataType)
+
+        if self.isFixed(dataType):
+
+            #A whole number of steps so the value is stored exactly
+            frac = types[listIndex]['frac']
+            data = random.randint(round(limits[0] * 2**frac),round(limits[1] * 2**frac)) / 2**frac
+        elif dataType not in ieeeCodes:
 
-            data = random.randint(types[listIndex]['min'],types[listIndex]['max'])
+            data = random.randint(limits[0],limits[1])
         else:
 
-            data = random.uniform(types[listIndex]['min'],types[listIndex]['max'])
+            #Scaled so the width of a double's range doesn't overflow
+            data = random.uniform(-1,1) * limits[1]
 
         logging.info('Random value {} of type {} generated'.format(data,dataType))
         return data
@@ -225,8 +465,11 @@ class Header():
         outStream += '#\t\tint16_t - Signed 16-bit integer. \n'
         outStream += '#\t\tuint32_t - Unsigned 32-bit integer. \n'
         outStream += '#\t\tint32_t - Signed 32-bit integer. \n'
-        outStream += '#\t\tfloat -  Floating point, up to four decimal point percision. \n'
+        outStream += '#\t\tfloat -  Floating point, up to four decimal point percision unless the UC stores IEEE floats. \n'
+        outStream += '#\t\tdouble - Double precision floating point. \n'
         outStream += '#\t\tchar - An ASCII character - valid from ASCII 32 to ASCII 127. \n'
+        outStream += '#\t\tq1.15, q8.8 - Signed 16-bit fixed point with 15 or 8 fractional bits, read as an int16_t. \n'
+        outStream += '#\t\tq1.31, q16.16 - Signed 32-bit fixed point with 31 or 16 fractional bits, read as an int32_t. \n'
         outStream += "#\tmax - The maximum allowed value, should be less the variable type's maximum. \n"
         outStream += "#\tmin - The minimum allowed value, should be less the variable type's minimum. \n"
         outStream += "\n# A single variable is demonstrated as: \n"
@@ -328,14 +571,18 @@ class Header():
 
         return True
 
-    def generateHeader(self,filename,dataList):
+    #If align is set the variables are given naturally aligned addresses first, see alignLayout()
+    def generateHeader(self,filename,dataList,align=False):
         
         if type(filename) != str:
             logging.warning('Filename for C header file must be of type "string", got type {}'.format(type(filename)))
             return False
 
+        if align == True:
+            self.alignLayout(dataList)
+
         outStream = ''
-        currentMemoryPosition = 0
+        layout = self.getLayout(dataList)
 
         outStream = outStream + '#ifndef UCCONFIG_GEN_H\n'
         outStream = outStream + '#define UCCONFIG_GEN_H\n'
@@ -345,11 +592,12 @@ class Header():
         outStream = outStream + '\t@details Generated: ' + datetime.datetime.strftime(datetime.datetime.now(),'%c') + '\n'
         outStream = outStream + '\tInclude this file in embedded programs code' + '\n'
         outStream = outStream + '*/\n'
+        outStream = outStream + '#include <ucconfig.h>\n'
 
         if len(dataList) < 1:
             logging.warning('Generating an C header file with no variables.')
 
-        for data in dataList:
+        for data,address in zip(dataList,layout):
 
             if not self.checkVariableName(data['name']):
                 logging.warning('Invalid variable names, header file not created')
@@ -363,8 +611,13 @@ class Header():
             outStream = outStream + '\t - Variable Type: ' + data['dataType'] +  '\n'
             outStream = outStream + '\tThe hexidecimal number is the variables location in non-volatile memory.\n'
             outStream = outStream + '*/\n'
-            outStream = outStream + '#define ' + data['name'] + ' ' + ' ' + hex(currentMemoryPosition) + '\n'
-            currentMemoryPosition = currentMemoryPosition + data['size']
+            outStream = outStream + '#define ' + data['name'] + ' ' + ' ' + hex(address) + '\n'
+
+            if self.isFixed(data['dataType']):
+                outStream = outStream + self.generateFixed(data)
+
+        if len(dataList) > 0:
+            outStream = outStream + self.generateStruct(dataList,layout)
 
         outStream = outStream + '\n#endif'
 
@@ -380,6 +633,66 @@ class Header():
 
         return True
 
+    #The number of fractional bits of a fixed point variable and a getter for its stored integer
+    #Use the UCCONFIG_Q_ macros on the integer so no float code is needed
+    def generateFixed(self,data):
+
+        cType = self.getCType(data['dataType'])
+        frac = types[self.getTypeIndex(data['dataType'])]['frac']
+
+        outStream = '/*!\n'
+        outStream = outStream + '\t@brief Number of fractional bits of ' + data['name'] + ', its value is the stored integer / 2^' + str(frac) + '.\n'
+        outStream = outStream + '*/\n'
+        outStream = outStream + '#define ' + data['name'] + '_FRAC ' + str(frac) + '\n'
+        outStream = outStream + '/*!\n'
+        outStream = outStream + '\t@brief Get the stored integer of ' + data['name'] + ', eg. UCCONFIG_Q_MUL(' + data['name'] + '_get(),x,' + data['name'] + '_FRAC).\n'
+        outStream = outStream + '*/\n'
+        outStream = outStream + 'static inline ' + cType + ' ' + data['name'] + '_get(void){\n'
+        outStream = outStream + '\t' + cType + ' value;\n'
+        outStream = outStream + '\tUCCONFIG_get(&value,' + data['name'] + ');\n'
+        outStream = outStream + '\treturn value;\n'
+        outStream = outStream + '}\n'
+
+        return outStream
+
+    #A packed struct mirroring the memory layout, and a function which fills it with one read
+    #Members are the variable names with _value appended, the names themselves are address defines
+    def generateStruct(self,dataList,layout):
+
+        #Members are in memory order, which differs from the list order for an aligned layout
+        dataList = [data for address,index,data in sorted(zip(layout,range(len(layout)),dataList))]
+        layout = sorted(layout)
+
+        outStream = '\n/*!\n'
+        outStream = outStream + '\t@brief All variables in the order they are stored in non-volatile memory.\n'
+        outStream = outStream + '\t@details Fill with ucconfig_load_all(). Each member is the variable name with _value appended.\n'
+        outStream = outStream + '*/\n'
+        outStream = outStream + 'typedef struct __attribute__((packed)){\n'
+
+        address = layout[0]
+
+        #Gaps of an aligned layout become padding members so the struct matches memory
+        for data,dataAddress in zip(dataList,layout):
+            if dataAddress > address:
+                outStream = outStream + '\tuint8_t padding_' + hex(address) + '[' + str(dataAddress - address) + '];\n'
+            outStream = outStream + '\t' + self.getCType(data['dataType']) + ' ' + data['name'] + '_value;\n'
+            address = dataAddress + data['size']
+
+        outStream = outStream + '}ucconfig_vars_t;\n'
+        outStream = outStream + '\n/*!\n'
+        outStream = outStream + '\t@brief Read every variable with a single read, then convert each one to its value.\n'
+        outStream = outStream + '\t@param vars Pointer to the struct to fill.\n'
+        outStream = outStream + '*/\n'
+        outStream = outStream + 'static inline void ucconfig_load_all(ucconfig_vars_t *vars){\n'
+        outStream = outStream + '\tUCCONFIG_read(' + hex(layout[0]) + ',(uint8_t*)vars,sizeof(ucconfig_vars_t));\n'
+
+        for data in dataList:
+            outStream = outStream + '\tUCCONFIG_decode(vars->' + data['name'] + '_value);\n'
+
+        outStream = outStream + '}\n'
+
+        return outStream
+
     def checkVariableName(self,name):
         
         if ' ' in name:
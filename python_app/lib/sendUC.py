@@ -3,6 +3,9 @@ import logging
 import re
 import time
 import numpy as np
+import collections
+import zlib
+from .header import Header
 
 UCCONFIG_KEY = [2,4,6,8]
 
@@ -14,6 +17,14 @@ UCCONFIG_TERMINATE = 15
 UCCONFIG_AT_ADDRESS = 16
 UCCONFIG_ACK = 17
 UCCONFIG_NACK = 18
+UCCONFIG_BULK_WRITE_FRAME = 23
+UCCONFIG_READ_BLOCK_FRAME = 24
+UCCONFIG_CRC_FRAME = 25
+UCCONFIG_SET_BAUD = 26
+UCCONFIG_COMMIT = 27
+UCCONFIG_FORMAT = 28
+UCCONFIG_ROLLBACK = 29
+UCCONFIG_STATS = 30
 
 UCCONFIG_NULL = 19
 UCCONFIG_NOT_USED = 20
@@ -32,6 +43,46 @@ UCCONFIG_TYPE_CHAR = 19
 
 UCCONFIG_LENGTH_ZERO = 21
 
+UCCONFIG_SEQUENCE_FIRST = 64
+UCCONFIG_SEQUENCE_LAST = 127
+
+#Size of the UC receive FIFO, frames in flight must fit in it
+UCCONFIG_FIFO_SIZE = 256
+
+#Maximum number of frames sent before waiting for the oldest acknowledge
+ucconfig_window = 4
+
+UCCONFIG_BULK_MAX_LENGTH = 96
+
+#Written into the gaps of an aligned layout
+ucconfig_padding = {'name':'padding','value':0,'dataType':'uint8_t','size':1}
+
+#Number of bytes requested in each read block frame
+ucconfig_readBlockSize = 64
+
+#Number of bytes covered by each CRC when comparing the UC memory with an image
+ucconfig_syncBlockSize = 32
+
+#Baud rates tried in config mode, fastest first
+ucconfig_baudRates = [3000000,2000000,1000000,921600,500000,460800,230400,115200,57600,38400,19200,9600]
+
+#Fraction of failed frames which causes the baud rate to drop a step
+ucconfig_maxErrorRate = 0.1
+
+#Number of frames sent at a baud rate before the error rate is trusted
+ucconfig_minErrorFrames = 8
+
+ucconfig_typeCodes = {
+        'uint8_t':UCCONFIG_TYPE_UINT8_T,
+        'int8_t':UCCONFIG_TYPE_INT8_T,
+        'uint16_t':UCCONFIG_TYPE_UINT16_T,
+        'int16_t':UCCONFIG_TYPE_INT16_T,
+        'uint32_t':UCCONFIG_TYPE_UINT32_T,
+        'int32_t':UCCONFIG_TYPE_INT32_T,
+        'float':UCCONFIG_TYPE_FLOAT,
+        'char':UCCONFIG_TYPE_CHAR,
+        }
+
 ack_length = 4
 nack_length = 4
 
@@ -61,6 +112,74 @@ ucconfig_terminate = bytearray([
         UCCONFIG_FRAME_END,
         ])
 
+ucconfig_commit = bytearray([
+        UCCONFIG_COMMIT,
+        UCCONFIG_NULL,
+        UCCONFIG_TYPE_NONE,
+        UCCONFIG_LENGTH_ZERO,
+        UCCONFIG_NOT_USED,
+        UCCONFIG_NOT_USED,
+        UCCONFIG_NULL,
+        UCCONFIG_FRAME_END,
+        ])
+
+ucconfig_format = bytearray([
+        UCCONFIG_FORMAT,
+        UCCONFIG_NULL,
+        UCCONFIG_TYPE_NONE,
+        UCCONFIG_LENGTH_ZERO,
+        UCCONFIG_NOT_USED,
+        UCCONFIG_NOT_USED,
+        UCCONFIG_NULL,
+        UCCONFIG_FRAME_END,
+        ])
+
+ucconfig_rollback = bytearray([
+        UCCONFIG_ROLLBACK,
+        UCCONFIG_NULL,
+        UCCONFIG_TYPE_NONE,
+        UCCONFIG_LENGTH_ZERO,
+        UCCONFIG_NOT_USED,
+        UCCONFIG_NOT_USED,
+        UCCONFIG_NULL,
+        UCCONFIG_FRAME_END,
+        ])
+
+ucconfig_stats = bytearray([
+        UCCONFIG_STATS,
+        UCCONFIG_NULL,
+        UCCONFIG_TYPE_NONE,
+        UCCONFIG_LENGTH_ZERO,
+        UCCONFIG_NOT_USED,
+        UCCONFIG_NOT_USED,
+        UCCONFIG_NULL,
+        UCCONFIG_FRAME_END,
+        ])
+
+ucconfig_statsResponseHeader = bytearray([
+        UCCONFIG_STATS,
+        UCCONFIG_NULL,
+        UCCONFIG_TYPE_UINT32_T,
+        UCCONFIG_LENGTH_ZERO,
+        UCCONFIG_NOT_USED,
+        UCCONFIG_NOT_USED,
+        ])
+
+ucconfig_formatResponseHeader = bytearray([
+        UCCONFIG_FORMAT,
+        UCCONFIG_NULL,
+        UCCONFIG_TYPE_UINT8_T,
+        UCCONFIG_LENGTH_ZERO,
+        UCCONFIG_NOT_USED,
+        UCCONFIG_NOT_USED,
+        ])
+
+#Byte order of each storage format the UC reports, the low bit of the format
+ucconfig_byteOrders = ['big','little']
+
+#Storage format flag set when floats are stored as their IEEE-754 bits
+ucconfig_formatFloatIeee = 2
+
 ucconfig_setMemoryHeader = bytearray([
         UCCONFIG_SET_MEMORY_ADDRESS,
         UCCONFIG_NULL,
@@ -72,6 +191,36 @@ ucconfig_writeFrameHeader = bytearray([
         UCCONFIG_NULL,
         ])
 
+ucconfig_bulkWriteHeader = bytearray([
+        UCCONFIG_BULK_WRITE_FRAME,
+        UCCONFIG_NULL,
+        UCCONFIG_TYPE_NONE,
+        ])
+
+ucconfig_readBlockHeader = bytearray([
+        UCCONFIG_READ_BLOCK_FRAME,
+        UCCONFIG_NULL,
+        UCCONFIG_TYPE_NONE,
+        ])
+
+ucconfig_readBlockResponseHeader = bytearray([
+        UCCONFIG_READ_BLOCK_FRAME,
+        UCCONFIG_NULL,
+        UCCONFIG_TYPE_NONE,
+        UCCONFIG_LENGTH_ZERO,
+        UCCONFIG_NOT_USED,
+        UCCONFIG_NOT_USED,
+        ])
+
+ucconfig_crcResponseHeader = bytearray([
+        UCCONFIG_CRC_FRAME,
+        UCCONFIG_NULL,
+        UCCONFIG_TYPE_UINT32_T,
+        UCCONFIG_LENGTH_ZERO,
+        UCCONFIG_NOT_USED,
+        UCCONFIG_NOT_USED,
+        ])
+
 ucconfig_atAddressHeader = bytearray([
         UCCONFIG_AT_ADDRESS,
         UCCONFIG_NULL,
@@ -115,6 +264,14 @@ class UC_coms:
         self.readTimeout = conf['readTimeout']
         self.portName = conf['serialPort']
         self.baud = conf['baud']
+        self.maxBaud = conf.get('maxBaud',self.baud)
+        self.commitTimeout = conf.get('commitTimeout',self.readTimeout)
+        self.head = Header(conf)
+        self.frameCount = 0
+        self.frameErrors = 0
+        self.formatKnown = False
+        self.hasStats = True
+        self.programmed = None
         return
 
     def connectSerial(self,portName=None,baud=None,retries=1):
@@ -128,6 +285,8 @@ class UC_coms:
         self.ser = serial.Serial(timeout=self.readTimeout)
         self.ser.baudrate = baud
         self.ser.port = portName
+        self.formatKnown = False
+        self.hasStats = True
 
         for r in range(retries):
             try:
@@ -220,6 +379,147 @@ class UC_coms:
 
         return self.getAck()
 
+    #Write a run of consecutive values in a single frame
+    #dataList is a list of (data,dataType) tuples, data already formatted as a string
+    def setBulkData(self,dataList):
+
+        if  self.ser == None:
+            logging.warning('Tyring to write data on serial port which is not open.')
+            return False
+
+        if not self.ser.is_open:
+            logging.warning('Tyring to write data on serial port which is not open.')
+            return False
+
+        if not self.inConfig:
+            logging.warning('Trying to write data when not in config mode')
+            return False
+
+        for data,dataType in dataList:
+
+            if dataType not in ucconfig_typeCodes:
+                logging.warning('Trying to write invalid data type: {}'.format(dataType))
+                return False
+
+            if type(data) != str:
+                logging.warning('Argument "Data" must be of type string, type: {}'.format(type(data)))
+                return False
+
+        payload = self.makeBulkPayload(dataList)
+
+        if len(payload) < 2 or len(payload) > UCCONFIG_BULK_MAX_LENGTH:
+            logging.warning('Bulk write payload length {} out of range'.format(len(payload)))
+            return False
+
+        logging.info('Writing {} values to current flash address'.format(len(dataList)))
+
+        if self.writeSerial(self.makeFrame(UCCONFIG_BULK_WRITE_FRAME,UCCONFIG_TYPE_NONE,payload)) == False:
+            return False
+
+        return self.getAck()
+
+    #Build a complete frame, the data is sent as given after the header
+    def makeFrame(self,command,dataType,data=b''):
+
+        if type(data) == str:
+            data = data.encode('UTF-8')
+
+        frame = bytearray([command,UCCONFIG_NULL,dataType])
+
+        if len(data) == 0:
+            frame += UCCONFIG_LENGTH_ZERO.to_bytes(1,'little')
+        else:
+            frame += (len(data) + 64).to_bytes(1,'little')
+
+        frame += UCCONFIG_NOT_USED.to_bytes(1,'little')
+        frame += UCCONFIG_NOT_USED.to_bytes(1,'little')
+        frame += data
+        frame += UCCONFIG_NULL.to_bytes(1,'little')
+        frame += UCCONFIG_FRAME_END.to_bytes(1,'little')
+        return frame
+
+    #Build the payload of a bulk write frame from a list of (data,dataType) tuples
+    def makeBulkPayload(self,dataList):
+
+        payload = bytearray()
+
+        for data,dataType in dataList:
+            payload += ucconfig_typeCodes[dataType].to_bytes(1,'little')
+            payload += data.encode('UTF-8')
+
+        return payload
+
+    #Send frames which are answered with an acknowledge without waiting for each one
+    #Returns the number of frames acknowledged in order, sending stops at the first frame which isn't.
+    def sendFrames(self,frames,window=ucconfig_window):
+
+        return len(self.requestFrames(frames,[self.parseAck] * len(frames),window))
+
+    #Send frames without waiting for each response
+    #Up to ucconfig_window frames are in flight, each tagged with a sequence character
+    #which the UC echoes in its response. Each response is passed to the matching check
+    #function with the sequence, which returns None or False if it's wrong. Returns the
+    #check results in order, sending stops at the first frame which fails.
+    def requestFrames(self,frames,checks,window=ucconfig_window):
+
+        if  self.ser == None:
+            logging.warning('Tyring to write data on serial port which is not open.')
+            return []
+
+        if not self.ser.is_open:
+            logging.warning('Tyring to write data on serial port which is not open.')
+            return []
+
+        if not self.inConfig:
+            logging.warning('Trying to write data when not in config mode')
+            return []
+
+        sequenceCount = UCCONFIG_SEQUENCE_LAST - UCCONFIG_SEQUENCE_FIRST + 1
+        outstanding = collections.deque()
+        buffered = 0
+        nextFrame = 0
+        results = []
+
+        while len(results) < len(frames):
+
+            #Fill the window, never send more than the UC FIFO can hold
+            while nextFrame < len(frames) and len(outstanding) < window:
+
+                if len(outstanding) > 0 and buffered + len(frames[nextFrame]) >= UCCONFIG_FIFO_SIZE:
+                    break
+
+                sequence = UCCONFIG_SEQUENCE_FIRST + (nextFrame % sequenceCount)
+                frame = bytearray(frames[nextFrame])
+                frame[1] = sequence
+
+                if self.writeSerial(frame) == False:
+                    self.drainInput()
+                    return results
+
+                outstanding.append((sequence,len(frame)))
+                buffered = buffered + len(frame)
+                nextFrame = nextFrame + 1
+
+            sequence,length = outstanding.popleft()
+            buffered = buffered - length
+
+            response = self.readLine()
+            result = None
+            self.frameCount = self.frameCount + 1
+
+            if response != None:
+                result = checks[len(results)](response,sequence)
+
+            if result is None or result is False:
+                logging.warning('Frame {} failed, {} frames in flight'.format(len(results),len(outstanding)))
+                self.frameErrors = self.frameErrors + 1
+                self.drainInput()
+                return results
+
+            results.append(result)
+
+        return results
+
     def getData(self,dataType):
 
         if  self.ser == None:
@@ -282,73 +582,401 @@ class UC_coms:
             logging.warning('Incorrect get data header, received {}'.format(response))
             return None
 
-        #Read the type
-        dataType = None
+        #Read the type
+        dataType = None
+
+
+        if chr(response[2]) == chr(UCCONFIG_TYPE_UINT8_T):
+            dataType = 'uint8_t'
+        elif chr(response[2]) == chr(UCCONFIG_TYPE_INT8_T):
+            dataType = 'int8_t'
+        elif chr(response[2]) == chr(UCCONFIG_TYPE_UINT16_T):
+            dataType = 'uint16_t'
+        elif chr(response[2]) == chr(UCCONFIG_TYPE_INT16_T):
+            dataType = 'int16_t'
+        elif chr(response[2]) == chr(UCCONFIG_TYPE_UINT32_T):
+            dataType = 'uint32_t'
+        elif chr(response[2]) == chr(UCCONFIG_TYPE_INT32_T):
+            dataType = 'int32_t'
+        elif chr(response[2]) == chr(UCCONFIG_TYPE_FLOAT):
+            dataType = 'float'
+        elif chr(response[2]) == chr(UCCONFIG_TYPE_CHAR):
+            dataType = 'char'
+        else:
+            logging.warning('Received invalid data type, received {}'.format(response))
+            return None
+
+
+
+        #Check the length of the data matches the actual data
+        if len((response[6:])[:-3]) > 24:
+            logging.warning('Length of data received is too long, received {}'.format(response))
+            return None
+
+        #Now should be two not used
+        if chr(response[4]) != chr(UCCONFIG_NOT_USED) and chr(response[5]) != chr(UCCONFIG_NOT_USED):
+            logging.warning('Not used bytes contain invalid characters, received {}'.format(response))
+            return None
+
+        #Check if float
+        if '.' in str(response[6:]) and dataType != 'char':
+            if dataType != 'float':
+                logging.warning('Decimal point in data but float type not specified, received {}'.format(response))
+                return None
+            else:
+                try:
+                    data = float((response[6:])[:-3])
+                except:
+                    logging.warning('Cannot parse float from {}'.format(response))
+                    return None
+
+        elif dataType == 'char':
+            data = chr(response[6])
+
+        else:
+            try: 
+                data = int((response[6:])[:-3])
+            except:
+                logging.warning('Cannot parse int from {}'.format(response))
+                return None
+
+        #Double check the Null character exists
+        if chr(response[-3]) != chr(UCCONFIG_NULL):
+            logging.warning('Null character not found, received: {}'.format(response))
+            return None
+
+
+        #All good
+        logging.info('Data {} of type {} at current address'.format(data,dataType))
+        return data
+
+    #Read a number of raw bytes from the current flash address in a single frame
+    def getBlock(self,length):
+
+        if  self.ser == None:
+            logging.warning('Tyring to get data on serial port which is not open.')
+            return None
+
+        if not self.ser.is_open:
+            logging.warning('Tyring to get data on serial port which is not open.')
+            return None
+
+        if not self.inConfig:
+            logging.warning('Trying to get data when not in config mode')
+            return None
+
+        logging.info('Requesting {} bytes at current flash address'.format(length))
+
+        if self.writeSerial(self.makeFrame(UCCONFIG_READ_BLOCK_FRAME,UCCONFIG_TYPE_NONE,str(length))) == False:
+            return None
+
+        response = self.readLine()
+
+        if response == None:
+            return None
+
+        #Basic Check for Nack
+        if response[0] == UCCONFIG_NACK:
+            logging.warning('Not acknowleged')
+            return None
+
+        if len(response) != len(ucconfig_readBlockResponseHeader) + 2 * length + 3:
+            logging.warning('Length of received block frame is incorrect, received {}'.format(response))
+            return None
+
+        if response[:6] != ucconfig_readBlockResponseHeader:
+            logging.warning('Incorrect read block header, received {}'.format(response))
+            return None
+
+        if response[-3] != UCCONFIG_NULL or response[-2] != UCCONFIG_FRAME_END:
+            logging.warning('Incorrect read block ending, received {}'.format(response))
+            return None
+
+        try:
+            data = bytes.fromhex(response[6:-3].decode('UTF-8'))
+        except:
+            logging.warning('Cannot parse block data from {}'.format(response))
+            return None
+
+        return data
+
+    #Read a region of memory, split into as many read block frames as needed
+    def readBlock(self,address,length,retries=1):
+
+        image = bytearray()
+
+        if not self.setMemoryAddress(str(address)):
+            logging.warning('Failed to set memory address')
+            return None
+
+        while len(image) < length:
+
+            chunkAddress = address + len(image)
+            chunk = None
+
+            for r in range(retries):
+
+                chunk = self.getBlock(min(ucconfig_readBlockSize,length - len(image)))
+
+                if chunk != None:
+                    break
+
+                logging.warning('Failed reading block on attempt number: {}'.format(r+1))
+
+                #The pointer may have moved, set it back to the start of the chunk
+                if not self.setMemoryAddress(str(chunkAddress)):
+                    logging.warning('Failed setting the block address on attempt number: {}'.format(r+1))
+
+            if chunk == None:
+                return None
+
+            image += chunk
+
+        return bytes(image)
+
+    #Get the CRC-32 of a number of bytes from the current flash address
+    #The UC doesn't move the memory address
+    def getCrc(self,length):
+
+        if  self.ser == None:
+            logging.warning('Tyring to get data on serial port which is not open.')
+            return None
+
+        if not self.ser.is_open:
+            logging.warning('Tyring to get data on serial port which is not open.')
+            return None
+
+        if not self.inConfig:
+            logging.warning('Trying to get data when not in config mode')
+            return None
+
+        logging.info('Requesting CRC of {} bytes at current flash address'.format(length))
+
+        if self.writeSerial(self.makeFrame(UCCONFIG_CRC_FRAME,UCCONFIG_TYPE_NONE,str(length))) == False:
+            return None
+
+        response = self.readLine()
+
+        if response == None:
+            return None
+
+        return self.parseCrc(response)
+
+    #Get the CRC from a CRC frame response, None if the response is invalid
+    def parseCrc(self,response,sequence=UCCONFIG_NULL):
+
+        #Basic Check for Nack
+        if response[0] == UCCONFIG_NACK:
+            logging.warning('Not acknowleged')
+            return None
+
+        if len(response) < 10:
+            logging.warning('Length of received CRC frame is too short, received {}'.format(response))
+            return None
+
+        #The UC echoes the frame sequence in place of the NULL
+        header = ucconfig_crcResponseHeader.copy()
+        header[1] = sequence
+
+        if response[:6] != header:
+            logging.warning('Incorrect CRC header, received {}'.format(response))
+            return None
+
+        if response[-3] != UCCONFIG_NULL or response[-2] != UCCONFIG_FRAME_END:
+            logging.warning('Incorrect CRC ending, received {}'.format(response))
+            return None
+
+        try:
+            crc = int(response[6:-3].decode('UTF-8'))
+        except:
+            logging.warning('Cannot parse CRC from {}'.format(response))
+            return None
+
+        return crc
+
+    #Get the CRC of each block of a region starting at address zero
+    #Every block needs its own set address frame, the pairs are all pipelined
+    def getBlockCrcs(self,length,blockSize=ucconfig_syncBlockSize):
+
+        frames = []
+        checks = []
+
+        for address in range(0,length,blockSize):
+            frames.append(self.makeFrame(UCCONFIG_SET_MEMORY_ADDRESS,UCCONFIG_TYPE_NONE,str(address)))
+            checks.append(self.parseAck)
+            frames.append(self.makeFrame(UCCONFIG_CRC_FRAME,UCCONFIG_TYPE_NONE,str(min(blockSize,length - address))))
+            checks.append(self.parseCrc)
+
+        results = self.requestFrames(frames,checks)
+
+        if len(results) != len(frames):
+            return None
+
+        return results[1::2]
+
+    #Verify a list of variables written from address zero
+    #The CRC of the whole region is compared first, values are only read back
+    #when it doesn't match. Returns the number of variables verified in order.
+    def verifyList(self,dataList,retries=1):
+
+        image = self.head.makeImage(dataList)
+
+        if len(image) == 0:
+            return 0
+
+        #Verify what is in flash, not what the UC has staged in RAM
+        if not self.commit(retries):
+            logging.warning('Failed committing data before verification')
+            return 0
+
+        for r in range(retries):
+
+            if not self.setMemoryAddress(str(0)):
+                logging.warning('Failed setting the CRC address on attempt number: {}'.format(r+1))
+                continue
+
+            crc = self.getCrc(len(image))
+
+            if crc == zlib.crc32(image):
+                logging.info('CRC of {} bytes matches'.format(len(image)))
+                return len(dataList)
+
+            if crc != None:
+                break
+
+            logging.warning('Failed reading CRC on attempt number: {}'.format(r+1))
+
+        #Find the variable which doesn't match
+        logging.warning('CRC mismatch, reading values back for verification')
+        readBack = self.readBlock(0,len(image),retries)
+
+        if readBack == None:
+            logging.warning('Failed reading data back for verification')
+            return 0
+
+        for index,(data,address) in enumerate(zip(dataList,self.head.getLayout(dataList))):
+
+            readValue = self.head.decodeValue(readBack[address:address+data['size']],data['dataType'])
+
+            if not self.checkValue(readValue,data['value'],data['dataType']):
+                logging.warning('Failed verifying data "{}" of value {} and type {}'.format(data['name'],data['value'],data['dataType']))
+                return index
+
+        return len(dataList)
+
+    #Change the baud rate of the config session
+    #The UC acknowledges at the current rate, then the request is repeated at the new rate to
+    #confirm it. If that fails both sides go back to the current rate, the UC after a timeout.
+    def setBaud(self,baud,retries=1):
+
+        if  self.ser == None:
+            logging.warning('Tyring to set baud rate on serial port which is not open.')
+            return False
+
+        if not self.ser.is_open:
+            logging.warning('Tyring to set baud rate on serial port which is not open.')
+            return False
+
+        if not self.inConfig:
+            logging.warning('Trying to set baud rate when not in config mode')
+            return False
+
+        oldBaud = self.ser.baudrate
+        frame = self.makeFrame(UCCONFIG_SET_BAUD,UCCONFIG_TYPE_NONE,str(baud))
+
+        logging.info('Setting baud rate to {}'.format(baud))
+
+        if self.writeSerial(frame) == False:
+            return False
+
+        if not self.getAck():
+            logging.warning('Baud rate {} not accepted'.format(baud))
+            return False
+
+        try:
+            self.ser.baudrate = baud
+        except:
+            logging.warning('Serial port does not support baud rate {}'.format(baud))
+
+        #Give the UC time to switch before confirming
+        time.sleep(0.01)
+
+        for r in range(retries):
+
+            if not self.flushInput():
+                break
+
+            if self.writeSerial(frame) == True and self.getAck() == True:
+                logging.info('Baud rate {} confirmed'.format(baud))
+                self.frameCount = 0
+                self.frameErrors = 0
+                return True
+
+            logging.warning('Failed to confirm baud rate {} on attempt number {}'.format(baud,r+1))
+
+        #Wait for the UC to time out and go back
+        self.ser.baudrate = oldBaud
+
+        for r in range(retries + 2):
+
+            self.drainInput()
+
+            if self.getMemoryAddress() != None:
+                break
+
+        return False
+
+    #Raise the baud rate to the fastest one both sides can use, up to maxBaud
+    def negotiateBaud(self,retries=1):
+
+        for baud in ucconfig_baudRates:
+
+            if baud > self.maxBaud:
+                continue
+
+            if baud <= self.ser.baudrate:
+                break
+
+            if self.setBaud(baud,retries):
+                return True
+
+        return False
 
+    #Drop the baud rate a step if too many frames have failed at the current one
+    def checkErrorRate(self):
 
-        if chr(response[2]) == chr(UCCONFIG_TYPE_UINT8_T):
-            dataType = 'uint8_t'
-        elif chr(response[2]) == chr(UCCONFIG_TYPE_INT8_T):
-            dataType = 'int8_t'
-        elif chr(response[2]) == chr(UCCONFIG_TYPE_UINT16_T):
-            dataType = 'uint16_t'
-        elif chr(response[2]) == chr(UCCONFIG_TYPE_INT16_T):
-            dataType = 'int16_t'
-        elif chr(response[2]) == chr(UCCONFIG_TYPE_UINT32_T):
-            dataType = 'uint32_t'
-        elif chr(response[2]) == chr(UCCONFIG_TYPE_INT32_T):
-            dataType = 'int32_t'
-        elif chr(response[2]) == chr(UCCONFIG_TYPE_FLOAT):
-            dataType = 'float'
-        elif chr(response[2]) == chr(UCCONFIG_TYPE_CHAR):
-            dataType = 'char'
-        else:
-            logging.warning('Received invalid data type, received {}'.format(response))
-            return None
+        if self.frameCount < ucconfig_minErrorFrames:
+            return False
 
+        if self.frameErrors / self.frameCount <= ucconfig_maxErrorRate:
+            return False
 
+        logging.warning('{} of {} frames failed at baud rate {}'.format(self.frameErrors,self.frameCount,self.ser.baudrate))
 
-        #Check the length of the data matches the actual data
-        if len((response[6:])[:-3]) > 24:
-            logging.warning('Length of data received is too long, received {}'.format(response))
-            return None
+        for baud in ucconfig_baudRates:
 
-        #Now should be two not used
-        if chr(response[4]) != chr(UCCONFIG_NOT_USED) and chr(response[5]) != chr(UCCONFIG_NOT_USED):
-            logging.warning('Not used bytes contain invalid characters, received {}'.format(response))
-            return None
+            if baud < self.baud:
+                break
 
-        #Check if float
-        if '.' in str(response[6:]) and dataType != 'char':
-            if dataType != 'float':
-                logging.warning('Decimal point in data but float type not specified, received {}'.format(response))
-                return None
-            else:
-                try:
-                    data = float((response[6:])[:-3])
-                except:
-                    logging.warning('Cannot parse float from {}'.format(response))
-                    return None
+            if baud < self.ser.baudrate and self.setBaud(baud):
+                return True
 
-        elif dataType == 'char':
-            data = chr(response[6])
+        return False
 
-        else:
-            try: 
-                data = int((response[6:])[:-3])
-            except:
-                logging.warning('Cannot parse int from {}'.format(response))
-                return None
+    #Compare a value read from the UC with the value which should be there
+    def checkValue(self,readValue,data,dataType):
 
-        #Double check the Null character exists
-        if chr(response[-3]) != chr(UCCONFIG_NULL):
-            logging.warning('Null character not found, received: {}'.format(response))
-            return None
+        if readValue == None:
+            return False
 
+        if dataType == 'char':
+            return readValue == chr(data)
 
-        #All good
-        logging.info('Data {} of type {} at current address'.format(data,dataType))
-        return data
+        #Compared as stored, the UC holds exactly what encodeValue() gives
+        if dataType in ['float','double'] or self.head.isFixed(dataType):
+            return readValue == self.head.decodeValue(self.head.encodeValue(data,dataType),dataType)
+
+        return readValue == int(data)
 
     def getMemoryAddress(self):
 
@@ -436,6 +1064,151 @@ class UC_coms:
         self.writeSerial(UCCONFIG_FRAME_END.to_bytes(1,'little'))
         return self.getAck()
 
+    #Write anything the UC has staged in RAM to flash, waiting up to commitTimeout for it
+    def commit(self,retries=1):
+
+        if  self.ser == None:
+            logging.warning('Tyring to commit on serial port which is not open.')
+            return False
+
+        if not self.ser.is_open:
+            logging.warning('Tyring to commit on serial port which is not open.')
+            return False
+
+        if not self.inConfig:
+            logging.warning('Trying to commit when not in config mode')
+            return False
+
+        for r in range(retries):
+
+            logging.info('Committing staged data')
+
+            if self.writeSerial(ucconfig_commit) == False:
+                return False
+
+            if self.getSlowAck() == True:
+                return True
+
+            logging.warning('Failed to commit on attempt number {}'.format(r+1))
+
+        return False
+
+    #Make the UC use the config in its other bank again, only for a UC set up with two banks
+    #The UC refuses if anything has been written this session
+    def rollback(self,retries=1):
+
+        if  self.ser == None:
+            logging.warning('Tyring to roll back on serial port which is not open.')
+            return False
+
+        if not self.ser.is_open:
+            logging.warning('Tyring to roll back on serial port which is not open.')
+            return False
+
+        if not self.inConfig:
+            logging.warning('Trying to roll back when not in config mode')
+            return False
+
+        for r in range(retries):
+
+            logging.info('Rolling back to the previous config')
+
+            if self.writeSerial(ucconfig_rollback) == False:
+                return False
+
+            if self.getAck() == True:
+                return True
+
+            logging.warning('Failed to roll back on attempt number {}'.format(r+1))
+
+        return False
+
+    #Ask the UC how multi byte values are stored and decode them that way
+    #A UC without the format command doesn't respond, it stores big endian
+    def getFormat(self):
+
+        logging.info('Requesting storage format')
+
+        if self.writeSerial(ucconfig_format) == False:
+            return False
+
+        response = self.readLine()
+        self.formatKnown = True
+        self.head.byteOrder = 'big'
+        self.head.floatFormat = 'scaled'
+
+        if response == None or len(response) < 10 or response[0] == UCCONFIG_NACK:
+            logging.info('No storage format, using big endian')
+            return True
+
+        if response[:6] != ucconfig_formatResponseHeader or response[-3] != UCCONFIG_NULL or response[-2] != UCCONFIG_FRAME_END:
+            logging.warning('Incorrect storage format frame, received {}'.format(response))
+            return False
+
+        try:
+            storageFormat = int(response[6:-3].decode('UTF-8'))
+        except:
+            logging.warning('Unknown storage format {}'.format(response))
+            return False
+
+        if storageFormat & ~(1 | ucconfig_formatFloatIeee):
+            logging.warning('Unknown storage format {}'.format(response))
+            return False
+
+        self.head.byteOrder = ucconfig_byteOrders[storageFormat & 1]
+
+        if storageFormat & ucconfig_formatFloatIeee:
+            self.head.floatFormat = 'ieee'
+
+        logging.info('Storage format is {} endian, {} floats'.format(self.head.byteOrder,self.head.floatFormat))
+        return True
+
+    #Ask the UC how many bytes it programmed this session, stored in self.programmed
+    #The UC skips bytes which already hold the value, so an unchanged config programs none.
+    #A UC without the stats command doesn't respond and isn't asked again on this connection
+    def getStats(self):
+
+        self.programmed = None
+
+        if not self.hasStats:
+            return None
+
+        logging.info('Requesting programmed byte count')
+
+        if self.writeSerial(ucconfig_stats) == False:
+            return None
+
+        #Anything staged is written before the UC responds
+        self.ser.timeout = max(self.readTimeout,self.commitTimeout)
+        response = self.readLine()
+        self.ser.timeout = self.readTimeout
+
+        if response == None or len(response) < 10 or response[0] == UCCONFIG_NACK:
+            logging.info('No programmed byte count')
+            self.hasStats = False
+            return None
+
+        if response[:6] != ucconfig_statsResponseHeader or response[-3] != UCCONFIG_NULL or response[-2] != UCCONFIG_FRAME_END:
+            logging.warning('Incorrect stats frame, received {}'.format(response))
+            return None
+
+        try:
+            self.programmed = int(response[6:-3].decode('UTF-8'))
+        except:
+            logging.warning('Cannot parse programmed byte count from {}'.format(response))
+            return None
+
+        logging.info('Programmed {} bytes'.format(self.programmed))
+        return self.programmed
+
+    #Get an acknowledge for a command which may write to flash before responding
+    def getSlowAck(self):
+
+        self.ser.timeout = max(self.readTimeout,self.commitTimeout)
+        ack = self.getAck()
+        self.ser.timeout = self.readTimeout
+        return ack
+
     def getAck(self):
 
         response = self.readLine()
@@ -445,16 +1218,22 @@ class UC_coms:
 
         return self.parseAck(response)
 
-    def parseAck(self,response):
+    def parseAck(self,response,sequence=UCCONFIG_NULL):
 
         if len(response) != ack_length:
             logging.warning('Wrong acknowledge length, received {}'.format(response))
             return False
 
-        if response == ucconfig_ack:
+        #The UC echoes the frame sequence in place of the NULL
+        ack = ucconfig_ack.copy()
+        ack[1] = sequence
+        nack = ucconfig_nack.copy()
+        nack[1] = sequence
+
+        if response == ack:
             logging.info('Acknowledged')
             return True
-        elif response == ucconfig_nack:
+        elif response == nack:
             logging.info('Not Acknowledged.')
             return False
         else:
@@ -462,42 +1241,279 @@ class UC_coms:
             return False
         return False
 
-    def sendList(self,dataList,verify=True,retries=1):
+    def sendList(self,dataList,verify=True,retries=1,bulk=True):
 
         if not self.enterConfigMode():
             logging.warning('Failed to enter config mode')
             self.exitConfigMode()
             return 0
 
+        #The float range depends on the storage format the UC reported
+        if not self.head.checkStorage(dataList):
+            self.exitConfigMode()
+            return 0
+
+        if bulk == True:
+            numberSent = self.sendBulk(dataList,verify,retries)
+            self.getStats()
+            self.exitConfigMode()
+            return numberSent
+
         numberSent = 0
+        address = 0
         if not self.setMemoryAddress(str(0)):
             logging.warning('Failed to set memory address')
             return 0
 
-        for data in dataList:
+        #Write in memory order, padding of an aligned layout is written as zero
+        dataList = self.sortByAddress(dataList)
+
+        #Values are verified together once they are all written
+        for data,dataAddress in zip(dataList,self.head.getLayout(dataList)):
+
+            if not all([self.send(0,'uint8_t',False,retries) for a in range(address,dataAddress)]):
+                logging.warning('Failed sending padding before data "{}"'.format(data['name']))
+                break
+
+            address = dataAddress + data['size']
 
-            if not self.send(data['value'],data['dataType'],verify,retries):
+            if not all([self.send(v,t,False,retries) for v,t in self.wireValues(data['value'],data['dataType'])]):
                 logging.warning('Failed sending data "{}" of value {} and type {}'.format(data['name'],data['value'],data['dataType']))
-                self.exitConfigMode()
-                return numberSent
+                break
             else:
                 numberSent = numberSent + 1
 
+        if verify == True and numberSent > 0:
+            numberSent = self.verifyList(dataList[:numberSent],retries)
+
+        self.getStats()
         self.exitConfigMode()
         return numberSent
 
-    def readList(self,dataList,retries=1):
+    #Order a list of variables by their memory address
+    def sortByAddress(self,dataList):
+
+        layout = self.head.getLayout(dataList)
+        return [dataList[i] for i in sorted(range(len(dataList)),key=lambda i: layout[i])]
+
+    #The (value,dataType) pairs written for a variable
+    #IEEE floats and doubles are sent as the uint32_t words of their stored bytes, so the UC
+    #doesn't parse them and stores exactly the bits encodeValue() gives
+    #Fixed point values are sent as their stored integer
+    def wireValues(self,data,dataType):
+
+        if self.head.isFixed(dataType):
+            raw = self.head.encodeValue(data,dataType)
+            return [(int.from_bytes(raw,self.head.byteOrder,signed=True),self.head.getCType(dataType))]
+
+        if not self.head.isIeee(dataType):
+            return [(data,dataType)]
+
+        raw = self.head.encodeValue(data,dataType)
+        return [(int.from_bytes(raw[i:i+4],self.head.byteOrder),'uint32_t') for i in range(0,len(raw),4)]
+
+    #Format a value as the string sent in a data frame
+    def formatValue(self,data,dataType):
+
+        if dataType == 'char':
+            return chr(data)
+        if dataType == 'float':
+            return self.head.formatScaled(data)
+        return str(data)
+
+    #Split the list into runs which each fit in a single bulk write frame
+    #A run also ends where the next variable isn't stored straight after the last one,
+    #unless pad is set where the gap is alignment padding and is filled with zeros
+    def makeBulkRuns(self,dataList,layout,pad=False):
+
+        runs = []
+        run = []
+        runLength = 0
+        address = 0
+        runAddress = 0
+
+        for data,dataAddress in zip(dataList,layout):
+
+            padding = []
+            if pad == True and len(run) > 0 and address < dataAddress:
+                padding = [ucconfig_padding] * (dataAddress - address)
+
+            itemLength = sum([1 + len(self.formatValue(v,t)) for v,t in self.wireValues(data['value'],data['dataType'])])
+            itemLength = itemLength + sum([1 + len(self.formatValue(p['value'],p['dataType'])) for p in padding])
+
+            if len(run) > 0 and (runLength + itemLength > UCCONFIG_BULK_MAX_LENGTH or (dataAddress != address and len(padding) == 0)):
+                runs.append((runAddress,run))
+                run = []
+                runLength = 0
+
+            if len(run) == 0:
+                runAddress = dataAddress - len(padding)
+
+            run.extend(padding)
+            run.append(data)
+            runLength = runLength + itemLength
+            address = dataAddress + data['size']
+
+        if len(run) > 0:
+            runs.append((runAddress,run))
+
+        return runs
+
+    #Send a list of variables using bulk write frames, packed from address zero unless
+    #a layout is given. Frames are pipelined, if one fails sending resumes from its run address
+    #Returns the number of variables sent (and verified if required, packed layout only)
+    def sendBulk(self,dataList,verify=True,retries=1,layout=None):
+
+        #Without a layout the whole list is sent, so gaps are alignment padding
+        pad = layout == None
+
+        if layout == None:
+            dataList = self.sortByAddress(dataList)
+            layout = self.head.getLayout(dataList)
+
+        runs = self.makeBulkRuns(dataList,layout,pad)
+        frames = []
+
+        for runAddress,run in runs:
+            values = [(self.formatValue(v,t),t) for d in run for v,t in self.wireValues(d['value'],d['dataType'])]
+            frames.append(self.makeFrame(UCCONFIG_BULK_WRITE_FRAME,UCCONFIG_TYPE_NONE,self.makeBulkPayload(values)))
+
+        start = 0
+
+        for r in range(retries):
+
+            if start == len(runs):
+                break
+
+            #Each attempt starts by pointing at the first run not yet acknowledged,
+            #after that only runs which don't follow on from the last need an address
+            attempt = []
+            isRun = []
+
+            for index in range(start,len(runs)):
+
+                previousEnd = None
+                if index > start:
+                    previousEnd = runs[index-1][0] + sum([d['size'] for d in runs[index-1][1]])
+
+                if runs[index][0] != previousEnd:
+                    attempt.append(self.makeFrame(UCCONFIG_SET_MEMORY_ADDRESS,UCCONFIG_TYPE_NONE,str(runs[index][0])))
+                    isRun.append(False)
+
+                attempt.append(frames[index])
+                isRun.append(True)
+
+            acknowledged = self.sendFrames(attempt)
+            start = start + sum(isRun[:acknowledged])
+
+            if start == len(runs):
+                break
+
+            logging.warning('Failed bulk write of run {} on attempt number {}'.format(start,r+1))
+            self.checkErrorRate()
+
+        numberSent = sum([len([d for d in run if d is not ucconfig_padding]) for runAddress,run in runs[:start]])
+
+        if verify == False or numberSent == 0:
+            return numberSent
+
+        return self.verifyList(dataList[:numberSent],retries)
+
+    #Bring the UC memory in line with a list of variables, only writing what changed
+    #The CRC of each block is compared with the image, blocks which differ are read
+    #back and only the variables whose stored bytes differ are written.
+    #Returns the number of variables in sync (and verified if required)
+    #Warning: an onFirstWrite function which erases memory will clear unchanged variables
+    def syncList(self,dataList,verify=True,retries=1,blockSize=ucconfig_syncBlockSize):
 
         if not self.enterConfigMode():
             logging.warning('Failed to enter config mode')
             self.exitConfigMode()
             return 0
 
-        if not self.setMemoryAddress(str(0)):
-            logging.warning('Failed to set memory address')
+        if not self.head.checkStorage(dataList):
+            self.exitConfigMode()
+            return 0
+
+        image = self.head.makeImage(dataList)
+        crcs = None
+
+        for r in range(retries):
+
+            crcs = self.getBlockCrcs(len(image),blockSize)
+
+            if crcs != None:
+                break
+
+            logging.warning('Failed reading block CRCs on attempt number: {}'.format(r+1))
+
+        if crcs == None:
+            self.exitConfigMode()
+            return 0
+
+        #Read back the blocks which differ to find exactly which bytes changed
+        current = bytearray(image)
+
+        for index,crc in enumerate(crcs):
+
+            address = index * blockSize
+            block = image[address:address + blockSize]
+
+            if crc == zlib.crc32(block):
+                continue
+
+            readBack = self.readBlock(address,len(block),retries)
+
+            if readBack == None:
+                logging.warning('Failed reading block at address {}'.format(address))
+                self.exitConfigMode()
+                return 0
+
+            current[address:address + len(block)] = readBack
+
+        changedList = []
+        changedLayout = []
+
+        for data,address in zip(dataList,self.head.getLayout(dataList)):
+
+            if current[address:address + data['size']] != image[address:address + data['size']]:
+                changedList.append(data)
+                changedLayout.append(address)
+
+        logging.info('{} of {} variables changed'.format(len(changedList),len(dataList)))
+
+        if len(changedList) > 0:
+
+            if self.sendBulk(changedList,False,retries,changedLayout) != len(changedList):
+                logging.warning('Failed writing changed variables')
+                self.exitConfigMode()
+                return 0
+
+        numberSent = len(dataList)
+
+        if verify == True:
+            numberSent = self.verifyList(dataList,retries)
+
+        self.getStats()
+        self.exitConfigMode()
+        return numberSent
+
+    def readList(self,dataList,retries=1):
+
+        if not self.enterConfigMode():
+            logging.warning('Failed to enter config mode')
             self.exitConfigMode()
             return 0
 
+        #Fetch the whole variable region at once and decode it locally
+        image = self.readBlock(0,self.head.getImageSize(dataList),retries)
+
+        self.exitConfigMode()
+
+        if image == None:
+            logging.warning('Failed reading memory region')
+            return None
+
         readList = []
         readDict = {
                 'name':None,
@@ -506,22 +1522,16 @@ class UC_coms:
                 'correct':None
                 }
 
-        for data in dataList:
+        for data,address in zip(dataList,self.head.getLayout(dataList)):
 
-           succeed,value,correct = self.read(data['value'],data['dataType'],retries)
-
-           if succeed == False:
-                self.exitConfigMode()
-                return None
+           value = self.head.decodeValue(image[address:address+data['size']],data['dataType'])
 
            readDict['name'] = data['name']
            readDict['value'] = data['value']
            readDict['read'] = value
-           readDict['correct'] = correct
+           readDict['correct'] = self.checkValue(value,data['value'],data['dataType'])
            readList.append(readDict.copy())
 
-        self.exitConfigMode()
-
         return readList
 
     def read(self,data,dataType,retries=1):
@@ -684,6 +1694,13 @@ class UC_coms:
             if self.getAck() == True:
                 self.inConfig = True
                 logging.info('Entering config mode.')
+
+                if self.maxBaud > self.ser.baudrate:
+                    self.negotiateBaud(retries)
+
+                #Only asked once per connection, it can't change while connected
+                if not self.formatKnown:
+                    self.getFormat()
                 return True
             else:
                 logging.warning('Failed to enter config mode on attempt number {}'.format(r+1))
@@ -711,10 +1728,15 @@ class UC_coms:
             if self.writeSerial(ucconfig_terminate) == None:
                 return False
 
-
-            if self.getAck() == True:
+            #The UC commits anything staged before acknowledging
+            if self.getSlowAck() == True:
                 self.inConfig = False
                 logging.info('Exiting config mode.')
+
+                #The UC goes back to its own baud rate after acknowledging
+                if self.ser.baudrate != self.baud:
+                    self.ser.baudrate = self.baud
+                    time.sleep(0.01)
                 return True
             else:
                 logging.warning('Failed to exit config mode on attempt number {}'.format(r+1))
@@ -746,6 +1768,12 @@ class UC_coms:
             return None
 
     
+    #Wait for responses to frames still in flight and throw them away
+    def drainInput(self):
+
+        time.sleep(self.readTimeout)
+        return self.flushInput()
+
     def flushInput(self):
         try:
             self.ser.flushInput()
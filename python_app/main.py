@@ -3,6 +3,7 @@ import argparse
 import lib.sendUC as coms
 import tests.UC_test as UC_test
 import tests.FULL_test as FULL_test
+import tests.HEADER_test as HEADER_test
 import lib.header as Header_C
 import lib.configParser as configParser
 import os
@@ -37,6 +38,10 @@ def handleArguments(arguments):
     if arguments['logLevel'] != None:
         changeLogLevel(arguments['logLevel'][0])
 
+    if arguments['rollback'] == True:
+        rollback()
+        return
+
     if arguments['input'] != None or arguments['output'] != None or arguments['query'] != None:
         flash(arguments)
         return
@@ -51,7 +56,7 @@ def handleArguments(arguments):
         generateExample()
 
     if arguments['read'] != None:
-        readValues(arguments['read'][0])
+        readValues(arguments['read'][0],arguments['align'])
 
     return
 
@@ -72,7 +77,7 @@ def setBaud(baud):
 #Reads flash values from microcontroller based on passed variable definition file
 #Checks read value for accuracy 
 #Prints information
-def readValues(fileName):
+def readValues(fileName,align=False):
 
     #Load the input file
     head = Header_C.Header(None)
@@ -82,6 +87,9 @@ def readValues(fileName):
         print('Error loading input file {}'.format(fileName))
         return
 
+    if align == True:
+        head.alignLayout(dataList)
+
     UC = coms.UC_coms(config)
 
     if not UC.connectSerial(retries=config['retries']):
@@ -100,6 +108,30 @@ def readValues(fileName):
 
     return
 
+#Switches the microcontroller back to the config it used before the last flash
+def rollback():
+
+    UC = coms.UC_coms(config)
+
+    if not UC.connectSerial(retries=config['retries']):
+        print('Error connecting to device on port {}'.format(config['serialPort']))
+        return
+
+    if not UC.enterConfigMode(retries=config['retries']):
+        print('Error entering config mode')
+        UC.closeSerial()
+        return
+
+    rolledBack = UC.rollback(retries=config['retries'])
+    UC.exitConfigMode(retries=config['retries'])
+    UC.closeSerial()
+
+    if not rolledBack:
+        print('Unable to roll back, the device has no previous config')
+        return
+
+    print('Rolled back to the previous config.')
+
 #Sends variables in given variable definition file to microcontroller
 #Verifies sent variables for accuracy
 def flash(arguments):
@@ -123,11 +155,17 @@ def flash(arguments):
                 print('Error loading query file {}'.format(arguments['query'][0]))
                 return
 
+            if arguments['align'] == True:
+                padding = head.alignLayout(dataList)
+
             #Print out the variables
             for data in dataList:
                 print('{}: {}'.format(data['name'],round(data['value'],4)))
                 
-            print('Variables require a total of {} bytes'.format(sum([d['size'] for d in dataList])))
+            print('Variables require a total of {} bytes'.format(head.getImageSize(dataList)))
+
+            if arguments['align'] == True:
+                print('Aligned layout adds {} bytes of padding'.format(padding))
 
     if arguments['input'] != None:
         if arguments['query'] != None:
@@ -142,6 +180,10 @@ def flash(arguments):
                 print('Error loading input file {}'.format(arguments['input'][0]))
                 return
 
+            #The header and the flashed image share the aligned addresses
+            if arguments['align'] == True:
+                print('Aligned layout adds {} bytes of padding'.format(head.alignLayout(dataList)))
+
     if arguments['output'] != None:
         #generate the header file
         if not head.generateHeader(arguments['output'][0],dataList):
@@ -158,7 +200,14 @@ def flash(arguments):
         return
 
     for i in range(config['retries']):
-        if UC.sendList(dataList) == len(dataList):
+
+        #Sync only writes the variables which differ from the UC memory
+        if arguments['sync'] == True:
+            numberSent = UC.syncList(dataList)
+        else:
+            numberSent = UC.sendList(dataList)
+
+        if numberSent == len(dataList):
             #Same size means everythin was sent
             UC.closeSerial()
             break
@@ -175,7 +224,11 @@ def flash(arguments):
     for data in dataList:
         print('{}: {}'.format(data['name'],round(data['value'],4)))
     print('-----------------')
-    print('Successfully verified {} bytes.'.format(sum([d['size'] for d in dataList])))
+    print('Successfully verified {} bytes.'.format(head.getImageSize(dataList)))
+
+    #Unchanged bytes aren't programmed again, older firmware doesn't report it
+    if UC.programmed != None:
+        print('Programmed {} bytes.'.format(UC.programmed))
 
 #Sets the log level for all modules
 def changeLogLevel(level):
@@ -215,6 +268,11 @@ def runTest(test):
 
         testFull = FULL_test.CleanTest(config,coms,Header_C,configParser)
         testFull.runTest()
+
+    elif test == 'header_values':
+
+        testHeader = HEADER_test.CleanTest(config,Header_C)
+        testHeader.runTest()
     else:
         #This shouldn't happen
         print('Unknown option "{}" received for argument'.format(arg['option'],arg['name']))
@@ -249,6 +307,12 @@ def makeArgs():
     parser.add_argument('-o','--output',
             metavar='',type=str,nargs=1,
             help='The generated C header file, requires input variable file.')
+    parser.add_argument('-s','--sync',
+            help='Only write variables which differ from those in the UC, used with input file.\n' +
+            'Not for UCs which erase memory on the first write.',action='store_true')
+    parser.add_argument('-a','--align',
+            help='Place each variable on its natural boundary, largest first, used with input, query or read file.\n' +
+            'The padding this adds is printed.',action='store_true')
     parser.add_argument('-q','--query',
             metavar='',type=str,nargs=1,
             help='Query a variable file, requries input *.yml variable file.')
@@ -270,13 +334,16 @@ def makeArgs():
             help='Run a module test.\n Options:' + '\n' + 
             '\tUC_coms_simple - Test UC communication with random variables'+ '\n' + 
             '\tfull_test - Run a test with good random variables, testing file parsing, generation and UC communication '+ '\n' + 
-            '',nargs=1,type=str,choices=['UC_coms_simple','full_test'])
+            '\theader_values - Check values read back the same after conversion to the bytes the UC stores, no UC needed '+ '\n' + 
+            '',nargs=1,type=str,choices=['UC_coms_simple','full_test','header_values'])
     parser.add_argument('-gc','--genConfig',
             metavar='',type=str,nargs=1,
             help='Generate a configuration file of given name in current directory.')
     parser.add_argument('-c','--config',
             metavar='',type=str,nargs=1,
             help='Use a custom configuration file.')
+    parser.add_argument('-rb','--rollback',
+            help='Switch a UC with two config banks back to the config used before the last flash.',action='store_true')
     parser.add_argument('-r','--read',
             metavar='',type=str,nargs=1,
             help='Read a configuration file and test its values against those in the connected UC.')
@@ -0,0 +1,71 @@
+import logging
+
+class CleanTest():
+
+    #Encode values to the bytes the UC stores for them
+    #Decode the bytes again and check the value comes back
+    #Scaled floats keep 4 decimal places, small magnitudes must not be sent in scientific notation
+
+    def __init__(self,config,header_module):
+
+        self.head = header_module.Header(config)
+        self.passedTests = 0
+        self.failedTests = 0
+
+        return
+
+    #Values with a decimal exponent from -8 to 3, both signs
+    def scaledValues(self):
+
+        values = []
+
+        for exponent in range(-8,4):
+            for digits in [1,15,25]:
+                values.append(digits * 10**exponent)
+                values.append(-digits * 10**exponent)
+
+        return values
+
+    def runSingleTest(self,value,dataType,tolerance):
+
+        decoded = self.head.decodeValue(self.head.encodeValue(value,dataType),dataType)
+        text = str(value)
+
+        #The string sent for a scaled float can't be in scientific notation
+        if dataType == 'float':
+            text = self.head.formatScaled(value)
+            if 'e' in text:
+                decoded = None
+
+        if (decoded == None) or (abs(decoded - value) > tolerance):
+            logging.warning('{} {} sent as {} decoded as {}'.format(dataType,value,text,decoded))
+            print('Failed: {} {} sent as {} decoded as {}'.format(dataType,value,text,decoded))
+            return False
+
+        return True
+
+    def runTest(self):
+
+        self.passedTests = 0
+        self.failedTests = 0
+
+        #Scaled floats are truncated to a step of 10^-4 after the UC's single precision parsing,
+        #so can be just over a step out. Doubles keep their bits and fixed point values are
+        #rounded to the nearest step of 2^-N
+        self.head.floatFormat = 'scaled'
+        tests = [(value,'float',1.01e-4) for value in self.scaledValues()]
+        tests += [(value,'double',0) for value in self.scaledValues()]
+        tests += [(value,'q1.15',2**-16) for value in self.scaledValues() if abs(value) < 1]
+
+        for value,dataType,tolerance in tests:
+
+            if self.runSingleTest(value,dataType,tolerance) == True:
+                self.passedTests = self.passedTests + 1
+            else:
+                self.failedTests = self.failedTests + 1
+
+        print('----------------')
+        print('Finished tests')
+        print('Test Passed: {}'.format(self.passedTests))
+        print('Test Failed: {}'.format(self.failedTests))
+        print('----------------')